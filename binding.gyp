@@ -4,14 +4,61 @@
             "cflags!": [ "-fno-exceptions" ],
             "cflags_cc!": [ "-fno-exceptions" ],
             "include_dirs": [
-                "<!@(node -p \"require('node-addon-api').include\")"
+                "<!@(node -p \"require('node-addon-api').include\")",
+                "<(INTERMEDIATE_DIR)"
             ],
             "target_name": "index",
             "sources": [ "src/cpp/lib.cc" ],
+            "actions": [
+                {
+                    "action_name": "codegen",
+                    "inputs": [
+                        "src/codegen.js",
+                        "<!@(node src/codegen.js --list)"
+                    ],
+                    "outputs": [ "<(INTERMEDIATE_DIR)/abi_generated.hpp" ],
+                    "action": [
+                        "node",
+                        "src/codegen.js",
+                        "<@(_outputs)",
+                        "<!@(node src/codegen.js --list)"
+                    ]
+                }
+            ],
             "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS" ],
             "cflags_cc": [
                 "-std=c++17"
             ]
+        },
+        {
+            "cflags!": [ "-fno-exceptions" ],
+            "cflags_cc!": [ "-fno-exceptions" ],
+            "target_name": "bench",
+            "type": "executable",
+            "sources": [ "src/cpp/bench.cc" ],
+            "cflags_cc": [
+                "-std=c++17"
+            ]
+        },
+        {
+            "cflags!": [ "-fno-exceptions" ],
+            "cflags_cc!": [ "-fno-exceptions" ],
+            "target_name": "num_test",
+            "type": "executable",
+            "sources": [ "src/cpp/num_test.cc" ],
+            "cflags_cc": [
+                "-std=c++17"
+            ]
+        },
+        {
+            "cflags!": [ "-fno-exceptions" ],
+            "cflags_cc!": [ "-fno-exceptions" ],
+            "target_name": "typed_test",
+            "type": "executable",
+            "sources": [ "src/cpp/typed_test.cc" ],
+            "cflags_cc": [
+                "-std=c++17"
+            ]
         }
     ]
 }
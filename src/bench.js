@@ -0,0 +1,90 @@
+// Compares encoding numeric arrays from the different JS representations,
+// the two ways of encoding nested values, and generated bindings against
+// plans.
+// Build with node-gyp and run `node src/bench.js`.
+const { compile, contracts, decode, encode } = require('../build/Release/index');
+
+const NUM_VALUES = 1 << 14;
+const NUM_ROUNDS = 32;
+
+function bench(name, plan, values, options) {
+    encode(plan, [values], options);
+    const start = process.hrtime.bigint();
+    for (let r = 0; r < NUM_ROUNDS; ++r) {
+        encode(plan, [values], options);
+    }
+    const ns = Number(process.hrtime.bigint() - start) / (NUM_VALUES * NUM_ROUNDS);
+    console.log(`  ${name.padEnd(30)} ${ns.toFixed(2).padStart(8)} ns/value`);
+    return ns;
+}
+
+const plan = compile(['uint256[]']);
+const numbers = [];
+const bigints = [];
+for (let i = 0; i < NUM_VALUES; ++i) {
+    numbers.push(Math.floor(Math.random() * Number.MAX_SAFE_INTEGER));
+    let n = 0n;
+    for (let j = 0; j < 4; ++j) {
+        n = (n << 64n) | BigInt(Math.floor(Math.random() * 2 ** 32)) << 32n;
+    }
+    bigints.push(n);
+}
+console.log('uint256[]');
+const fromString = bench('string (53 bits)', plan, numbers.map(String));
+const fromNumber = bench('number (53 bits)', plan, numbers);
+console.log(`  speedup: ${(fromString / fromNumber).toFixed(1)}x`);
+const fromBigString = bench('string (256 bits)', plan, bigints.map(String));
+const fromBigInt = bench('bigint (256 bits)', plan, bigints);
+console.log(`  speedup: ${(fromBigString / fromBigInt).toFixed(1)}x`);
+
+const uint32Plan = compile(['uint32[]']);
+const uint32s = numbers.map(n => n % 2 ** 32);
+console.log('uint32[]');
+const fromArray = bench('array', uint32Plan, uint32s);
+const fromTyped = bench('Uint32Array', uint32Plan, new Uint32Array(uint32s));
+console.log(`  speedup: ${(fromArray / fromTyped).toFixed(1)}x`);
+
+// Static tuples, whose words `encode()` writes in place as it reads them
+// (`write_static()`), rather than building a node per field. Reading the
+// JS values takes most of the time.
+const staticPlan = compile([{ type: 'tuple[]', components: [{ type: 'uint256' }, { type: 'address' }] }]);
+const staticTuples = numbers.map((n, i) => [n, '0x' + (i % 256).toString(16).padStart(2, '0').repeat(20)]);
+console.log('(uint256,address)[]');
+bench('encode', staticPlan, staticTuples);
+
+// Lists of dynamic tuples, built as a value tree first or encoded in a
+// single pass.
+const tuplePlan = compile([{
+    type: 'tuple[]',
+    components: [{ type: 'uint256' }, { type: 'bytes' }, { type: 'uint64[]' }],
+}]);
+const tuples = numbers.map((n, i) => [n, Buffer.alloc(i % 64, i % 256), [i, n]]);
+console.log('(uint256,bytes,uint64[])[]');
+const fromTree = bench('value tree', tuplePlan, tuples);
+const fromSinglePass = bench('single pass', tuplePlan, tuples, { singlePass: true });
+console.log(`  speedup: ${(fromTree / fromSinglePass).toFixed(1)}x`);
+
+// Calls encoded and decoded by plan, or by the bindings generated from
+// `abi/` at build time.
+function benchCalls(name, fn) {
+    fn();
+    const start = process.hrtime.bigint();
+    for (let i = 0; i < NUM_VALUES; ++i) {
+        fn();
+    }
+    const ns = Number(process.hrtime.bigint() - start) / NUM_VALUES;
+    console.log(`  ${name.padEnd(30)} ${ns.toFixed(2).padStart(8)} ns/call`);
+    return ns;
+}
+
+const transfer = contracts.erc20.functions.transfer;
+const transferPlan = compile(require('../abi/erc20.json').find(f => f.name === 'transfer'));
+const transferArgs = ['0x' + '11'.repeat(20), 123456789n];
+const calldata = transfer.encode(transferArgs);
+console.log(transfer.signature);
+const encodeByPlan = benchCalls('encode by plan', () => encode(transferPlan, transferArgs));
+const encodeGenerated = benchCalls('encode generated', () => transfer.encode(transferArgs));
+console.log(`  speedup: ${(encodeByPlan / encodeGenerated).toFixed(1)}x`);
+const decodeByPlan = benchCalls('decode by plan', () => decode(transferPlan, calldata));
+const decodeGenerated = benchCalls('decode generated', () => transfer.decode(calldata));
+console.log(`  speedup: ${(decodeByPlan / decodeGenerated).toFixed(1)}x`);
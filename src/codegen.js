@@ -0,0 +1,219 @@
+// Generates C++ bindings for contract ABIs known at build time, so their
+// functions and events are encoded and decoded by types fixed at compile
+// time (`src/cpp/typed.hpp`) instead of by walking a plan. The addon
+// exports them as:
+//
+//     contracts.<file name>.functions.<name or signature, if overloaded>
+//     contracts.<file name>.events.<name or signature, if overloaded>
+//
+// See `typed_function()` and `typed_event()` in `src/cpp/lib.cc` for what
+// each has. ABIs are JSON files in `abi/` (or `$ABI_DIR`), either an array
+// of fragments or an object with an `abi` array, like a compiler artifact.
+//
+//     node src/codegen.js <out.hpp> <abi.json>...
+//     node src/codegen.js --list    # ABI files, for binding.gyp
+const fs = require('fs');
+const path = require('path');
+
+function listAbiFiles() {
+    const dir = process.env.ABI_DIR || 'abi';
+    if (!fs.existsSync(dir)) {
+        return [];
+    }
+    return fs.readdirSync(dir)
+        .filter(f => f.endsWith('.json'))
+        .sort()
+        .map(f => path.join(dir, f));
+}
+
+// The canonical type of a parameter, as in signatures.
+function canonicalType(param) {
+    const array = /^(.*)(\[\d*\])$/.exec(param.type);
+    if (array) {
+        return canonicalType({ ...param, type: array[1] }) + array[2];
+    }
+    if (param.type === 'tuple') {
+        return `(${param.components.map(canonicalType).join(',')})`;
+    }
+    if (param.type === 'uint' || param.type === 'int') {
+        return `${param.type}256`;
+    }
+    return param.type;
+}
+
+function signature(fragment) {
+    return `${fragment.name}(${fragment.inputs.map(canonicalType).join(',')})`;
+}
+
+// The namespace of a contract's bindings. Prefixed, so file names can't
+// collide with keywords (`int.json`) or shadow namespaces used in the
+// generated code (`abi.json`).
+function namespace(name) {
+    return `contract_${name.replace(/[^A-Za-z0-9_]/g, '_')}`;
+}
+
+class ContractWriter {
+    constructor() {
+        // Structs naming the fields of tuples.
+        this.names = [];
+    }
+
+    // The `typed.hpp` type for a parameter.
+    type(param) {
+        const array = /^(.*)\[(\d*)\]$/.exec(param.type);
+        if (array) {
+            const element = this.type({ ...param, type: array[1] });
+            return array[2] ? `abi::array<${element}, ${array[2]}>` : `abi::array<${element}>`;
+        }
+        const type = param.type;
+        if (type === 'tuple') {
+            return this.tuple(param.components);
+        }
+        if (type === 'bool' || type === 'address' || type === 'bytes' || type === 'string') {
+            return type === 'bool' ? 'abi::bool_' : `abi::${type}`;
+        }
+        let m = /^bytes(\d+)$/.exec(type);
+        const size = m && Number(m[1]);
+        if (m && size >= 1 && size <= 32) {
+            return `abi::fixed_bytes<${size}>`;
+        }
+        m = /^(u?)int(\d*)$/.exec(type);
+        const bits = m && (m[2] ? Number(m[2]) : 256);
+        if (m && bits >= 8 && bits <= 256 && bits % 8 === 0) {
+            return m[1] ? `abi::uint<${bits}>` : `abi::int_<${bits}>`;
+        }
+        throw new Error(`unsupported ABI type: ${type}`);
+    }
+
+    // A tuple of `params`, named if any of them are and `named` is set.
+    tuple(params, named = true) {
+        const types = params.map(p => this.type(p));
+        if (!named || !params.some(p => p.name)) {
+            return `abi::tuple<${types.join(', ')}>`;
+        }
+        const names = `names_${this.names.length}`;
+        const strings = params.map(p => JSON.stringify(p.name || ''));
+        this.names.push(
+            `        struct ${names} {\n`
+            + `            static constexpr const char* names[] = { ${strings.join(', ')} };\n`
+            + `        };\n`,
+        );
+        return `abi::named_tuple<${[names, ...types].join(', ')}>`;
+    }
+
+    // Parameters and results are unnamed, as in `decode()`, but their
+    // tuples' fields aren't.
+    function(fragment) {
+        return [
+            'typed_function<',
+            `    ${this.tuple(fragment.inputs, false)},`,
+            `    ${this.tuple(fragment.outputs || [], false)}`,
+            `>(env, ${JSON.stringify(fragment.name)})`,
+        ];
+    }
+
+    // Parameters are named, as logs are usually read by name. The data's
+    // fields are only read by position.
+    event(fragment) {
+        const indexed = fragment.inputs.map(p => Boolean(p.indexed));
+        const data = fragment.inputs.filter(p => !p.indexed);
+        return [
+            'typed_event<',
+            `    ${this.tuple(fragment.inputs)},`,
+            `    ${this.tuple(data, false)}${indexed.length ? ',' : ''}`,
+            ...indexed.length ? [`    ${indexed.join(', ')}`] : [],
+            `>(env, ${JSON.stringify(fragment.name)}, ${Boolean(fragment.anonymous)})`,
+        ];
+    }
+}
+
+// Keys fragments of a kind by name, or by signature when overloaded.
+function keyed(fragments) {
+    const counts = {};
+    for (const f of fragments) {
+        counts[f.name] = (counts[f.name] || 0) + 1;
+    }
+    return fragments.map(f => [counts[f.name] > 1 ? signature(f) : f.name, f]);
+}
+
+function generateContract(name, abi) {
+    const writer = new ContractWriter();
+    const lines = [];
+    for (const kind of ['function', 'event']) {
+        const object = `${kind}s`;
+        lines.push(`            auto ${object} = Napi::Object::New(env);`);
+        for (const [key, fragment] of keyed(abi.filter(f => f.type === kind))) {
+            let call;
+            try {
+                call = writer[kind](fragment);
+            } catch (err) {
+                console.warn(`${name}: skipping ${signature(fragment)}: ${err.message}`);
+                lines.push(`            // Skipped ${signature(fragment)}: ${err.message}`);
+                continue;
+            }
+            lines.push(
+                `            // ${signature(fragment)}`,
+                `            ${object}.Set(${JSON.stringify(key)}, ${call[0]}`,
+                ...call.slice(1, -1).map(l => `            ${l}`),
+                `            ${call[call.length - 1]});`,
+            );
+        }
+    }
+    return [
+        `    namespace ${namespace(name)} {`,
+        ...writer.names.map(n => n.replace(/\n$/, '')),
+        ...writer.names.length ? [''] : [],
+        `        Napi::Object contract(Napi::Env env) {`,
+        ...lines,
+        `            auto contract = Napi::Object::New(env);`,
+        `            contract.Set("functions", functions);`,
+        `            contract.Set("events", events);`,
+        `            return contract;`,
+        `        }`,
+        `    }`,
+    ].join('\n');
+}
+
+function generate(files) {
+    const contracts = files.map(file => {
+        let abi = JSON.parse(fs.readFileSync(file, 'utf8'));
+        if (!Array.isArray(abi)) {
+            abi = abi.abi;
+        }
+        if (!Array.isArray(abi)) {
+            throw new Error(`${file}: expected an ABI array or an object with one`);
+        }
+        return { name: path.basename(file, '.json'), abi, file };
+    });
+    const filesByNamespace = {};
+    for (const c of contracts) {
+        const ns = namespace(c.name);
+        if (filesByNamespace[ns]) {
+            throw new Error(`${filesByNamespace[ns]} and ${c.file} both map to namespace ${ns}; rename one`);
+        }
+        filesByNamespace[ns] = c.file;
+    }
+    return [
+        `// Generated by src/codegen.js from ${files.length ? files.join(', ') : 'no ABIs'}.`,
+        '// Do not edit.',
+        'namespace generated {',
+        ...contracts.map(c => generateContract(c.name, c.abi) + '\n'),
+        '    Napi::Object contracts(Napi::Env env) {',
+        '        auto contracts = Napi::Object::New(env);',
+        ...contracts.map(c => `        contracts.Set(${JSON.stringify(c.name)}, ${namespace(c.name)}::contract(env));`),
+        '        return contracts;',
+        '    }',
+        '}',
+        '',
+    ].join('\n');
+}
+
+const args = process.argv.slice(2);
+if (args[0] === '--list') {
+    console.log(listAbiFiles().join(' '));
+} else if (args.length) {
+    fs.writeFileSync(args[0], generate(args.slice(1)));
+} else {
+    console.error('usage: node src/codegen.js <out.hpp> <abi.json>... | --list');
+    process.exit(1);
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace encoder {
+    using namespace std;
+
+    // A non-owning view of `size` contiguous `T`s, e.g., an array allocated
+    // from an `Arena` or memory borrowed from the caller.
+    template <class T>
+    class array_ref {
+    private:
+        T* _data;
+        size_t _size;
+
+    public:
+        array_ref(): _data(nullptr), _size(0) {}
+        array_ref(T* data, size_t size): _data(data), _size(size) {}
+        template <class U, typename enable_if<is_convertible<U*, T*>::value, int>::type = 0>
+        array_ref(const array_ref<U>& o): _data(o.data()), _size(o.size()) {}
+        T* data() const { return _data; }
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        T* begin() const { return _data; }
+        T* end() const { return _data + _size; }
+        const T* cbegin() const { return _data; }
+        const T* cend() const { return _data + _size; }
+        T& operator[](size_t i) const { return _data[i]; }
+    };
+
+    // Bump allocator for objects that are all freed together. Allocations
+    // are carved out of large blocks, and rewinding keeps the blocks for the
+    // next use, so a warm arena serves a whole encode without touching the
+    // heap. Destructors are never run: only objects whose members are
+    // trivially destructible (including `array_ref`s into the arena) may be
+    // allocated here.
+    class Arena {
+    private:
+        struct Block {
+            unique_ptr<byte[]> data;
+            size_t size;
+        };
+        vector<Block> _blocks;
+        // Where the next allocation goes.
+        size_t _block = 0;
+        size_t _pos = 0;
+
+    public:
+        static constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+        // Rewinding to the start frees blocks beyond this much capacity, so
+        // one huge encode doesn't pin its memory forever.
+        static constexpr size_t MAX_RETAINED_SIZE = 16 * 1024 * 1024;
+
+        struct Mark {
+            size_t block;
+            size_t pos;
+        };
+
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // One arena per thread, reused across encodes on that thread.
+        static Arena& for_this_thread() {
+            thread_local Arena arena;
+            return arena;
+        }
+
+        size_t capacity() const {
+            size_t total = 0;
+            for (const auto& b : _blocks) {
+                total += b.size;
+            }
+            return total;
+        }
+
+        void* allocate(size_t size, size_t align) {
+            assert(align && (align & (align - 1)) == 0 && align <= alignof(max_align_t));
+            for (; _block < _blocks.size(); ++_block, _pos = 0) {
+                const auto& b = _blocks[_block];
+                auto start = (_pos + align - 1) & ~(align - 1);
+                if (start <= b.size && size <= b.size - start) {
+                    _pos = start + size;
+                    return b.data.get() + start;
+                }
+            }
+            // Grow geometrically so the number of blocks stays small.
+            auto block_size = max(max(MIN_BLOCK_SIZE, size), capacity());
+            _blocks.push_back({ unique_ptr<byte[]>(new byte[block_size]), block_size });
+            _block = _blocks.size() - 1;
+            _pos = size;
+            return _blocks.back().data.get();
+        }
+
+        template <class T, typename... TArgs>
+        T* make(TArgs&&... args) {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+        }
+
+        // Uninitialized storage for `n` trivial `T`s.
+        template <class T>
+        array_ref<T> make_array(size_t n) {
+            static_assert(is_trivial<T>::value, "arena arrays hold trivial types");
+            if (!n) {
+                return array_ref<T>();
+            }
+            return array_ref<T>((T*) allocate(n * sizeof(T), alignof(T)), n);
+        }
+
+        template <class T>
+        array_ref<T> copy_array(const T* data, size_t n) {
+            auto arr = make_array<T>(n);
+            if (n) {
+                memcpy(arr.data(), data, n * sizeof(T));
+            }
+            return arr;
+        }
+
+        Mark mark() const {
+            return { _block, _pos };
+        }
+
+        // Frees everything allocated since `m`.
+        void rewind(const Mark& m) {
+            _block = m.block;
+            _pos = m.pos;
+            if (_block == 0 && _pos == 0) {
+                while (_blocks.size() > 1 && capacity() > MAX_RETAINED_SIZE) {
+                    _blocks.pop_back();
+                }
+            }
+        }
+
+        void reset() {
+            rewind({ 0, 0 });
+        }
+    };
+}
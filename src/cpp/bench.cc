@@ -0,0 +1,356 @@
+// Micro-benchmarks for the encoder primitives. Build with node-gyp and run
+// `build/Release/bench`.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include "encoders.hpp"
+#include "utf8.hpp"
+
+using namespace std;
+using namespace encoder;
+
+static const size_t NUM_WORDS = 1 << 16;
+static const size_t NUM_ROUNDS = 64;
+
+// Runs `fn(buf, i)` for every word slot and reports ns per word.
+template <class TFn>
+double bench(const char* name, TFn fn) {
+    buf_t out(NUM_WORDS * ETH_WORD_SIZE);
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < NUM_ROUNDS; ++r) {
+        EncodeBuffer buf(out.data(), out.size());
+        for (size_t i = 0; i < NUM_WORDS; ++i) {
+            fn(buf, i);
+        }
+    }
+    auto elapsed = chrono::duration<double, nano>(
+        chrono::steady_clock::now() - start
+    ).count();
+    // Keep the output observable so the writes aren't optimized away.
+    unsigned checksum = 0;
+    for (auto b : out) {
+        checksum += unsigned(b);
+    }
+    auto ns = elapsed / (NUM_WORDS * NUM_ROUNDS);
+    printf("%-32s %8.2f ns/word (checksum %u)\n", name, ns, checksum);
+    return ns;
+}
+
+void bench_write_word() {
+    mt19937_64 rng(0x5eed);
+    vector<size_t> sizes(NUM_WORDS);
+    vector<uint256_t> numbers(NUM_WORDS);
+    for (size_t i = 0; i < NUM_WORDS; ++i) {
+        sizes[i] = rng() >> 32;
+        numbers[i] = uint256_t(rng());
+        for (size_t j = 0; j < 3; ++j) {
+            numbers[i] = (numbers[i] << 64) | uint256_t(rng());
+        }
+    }
+    printf("write_word\n");
+    auto slow = bench("  size_t (generic)", [&](EncodeBuffer& buf, size_t i) {
+        write_word_generic(buf, sizes[i]);
+    });
+    auto fast = bench("  size_t", [&](EncodeBuffer& buf, size_t i) {
+        write_word(buf, sizes[i]);
+    });
+    printf("  speedup: %.1fx\n", slow / fast);
+    slow = bench("  uint256_t (generic)", [&](EncodeBuffer& buf, size_t i) {
+        write_word_generic(buf, numbers[i]);
+    });
+    fast = bench("  uint256_t", [&](EncodeBuffer& buf, size_t i) {
+        write_word(buf, numbers[i]);
+    });
+    printf("  speedup: %.1fx\n", slow / fast);
+}
+
+// One address word at a time vs. the whole array through the kernel.
+void bench_pad_words() {
+    mt19937_64 rng(0x5eed);
+    buf_t items(NUM_WORDS * 20);
+    for (auto& b : items) {
+        b = byte(rng());
+    }
+    printf("pad_words\n");
+    auto slow = bench("  address (per element)", [&](EncodeBuffer& buf, size_t i) {
+        values::AddressValue(items.data() + i * 20).encode_to(buf);
+    });
+    auto fast = bench("  address", [&](EncodeBuffer& buf, size_t i) {
+        if (i == 0) {
+            kernels::pad_words(
+                buf.advance(NUM_WORDS * ETH_WORD_SIZE),
+                items.data(),
+                NUM_WORDS,
+                20,
+                true
+            );
+        }
+    });
+    printf("  speedup: %.1fx\n", slow / fast);
+}
+
+// Native unsigned integers one word at a time vs. the dispatched kernel,
+// four words per iteration on AVX2. A 256-element array is encoded over
+// and over into the same memory, after a 4-byte selector like calldata
+// (so words aren't aligned), as into the per-thread output buffer.
+template <class TUint>
+void bench_widen_uint_words(const char* name) {
+    const size_t length = 256;
+    mt19937_64 rng(0x5eed);
+    vector<TUint> numbers(length);
+    for (auto& n : numbers) {
+        n = TUint(rng());
+    }
+    auto encode_arrays = [&](EncodeBuffer& buf, size_t i, auto kernel) {
+        if (i % length == 0) {
+            auto out = buf.view(4);
+            kernel(out.advance(length * ETH_WORD_SIZE), numbers.data(), length);
+        }
+    };
+    printf("widen_uint_words (%s[%zu])\n", name, length);
+    auto slow = bench("  generic", [&](EncodeBuffer& buf, size_t i) {
+        encode_arrays(buf, i, kernels::widen_uint_words_generic<TUint>);
+    });
+    auto fast = bench("  widen_uint_words", [&](EncodeBuffer& buf, size_t i) {
+        encode_arrays(buf, i, kernels::widen_uint_words<TUint>);
+    });
+    printf("  speedup: %.1fx\n", slow / fast);
+}
+
+// A 100 KB `bytes` payload, byte by byte vs. `EncodeBuffer::write()`.
+void bench_write_bytes() {
+    const size_t bytes_size = 100 * 1024;
+    mt19937_64 rng(0x5eed);
+    buf_t bytes(bytes_size);
+    for (auto& b : bytes) {
+        b = byte(rng());
+    }
+    const size_t words_per_copy = bytes_size / ETH_WORD_SIZE;
+    printf("write (100 KB bytes)\n");
+    auto slow = bench("  byte loop", [&](EncodeBuffer& buf, size_t i) {
+        if (i % words_per_copy == 0 && i + words_per_copy <= NUM_WORDS) {
+            auto p = buf.advance(bytes_size);
+            // Volatile so the compiler doesn't turn this back into a memcpy.
+            for (size_t j = 0; j < bytes_size; ++j) {
+                ((volatile byte*) p)[j] = bytes[j];
+            }
+        }
+    });
+    auto fast = bench("  write", [&](EncodeBuffer& buf, size_t i) {
+        if (i % words_per_copy == 0 && i + words_per_copy <= NUM_WORDS) {
+            buf.write(bytes.data(), bytes.data() + bytes_size);
+        }
+    });
+    printf("  speedup: %.1fx\n", slow / fast);
+}
+
+// Validating a mostly ASCII string, one sequence at a time vs.
+// `utf8::is_valid()`, which skips ASCII runs with vector loads.
+void bench_validate_utf8() {
+    const size_t text_size = NUM_WORDS * ETH_WORD_SIZE;
+    mt19937_64 rng(0x5eed);
+    buf_t text(text_size);
+    for (size_t i = 0; i < text_size; ++i) {
+        text[i] = byte(' ' + rng() % 95);
+        // An occasional "é".
+        if (i % 100 == 99) {
+            text[i - 1] = byte(0xC3);
+            text[i] = byte(0xA9);
+        }
+    }
+    printf("validate UTF-8 (2 MB string)\n");
+    auto slow = bench("  per sequence", [&](EncodeBuffer& buf, size_t i) {
+        if (i == 0) {
+            bool ok = true;
+            for (size_t j = 0, n; j < text_size && ok; j += n) {
+                n = utf8::sequence_size(text.data() + j, text_size - j);
+                ok = n != 0;
+            }
+            buf.fill(byte(ok), 1);
+        }
+    });
+    auto fast = bench("  is_valid", [&](EncodeBuffer& buf, size_t i) {
+        if (i == 0) {
+            buf.fill(byte(utf8::is_valid(text.data(), text_size)), 1);
+        }
+    });
+    printf("  speedup: %.1fx\n", slow / fast);
+}
+
+// The tuple and array values as they were before list sizes were memoized:
+// sizes are summed from the elements on every call, and a tuple sizes its
+// head again to encode, so each level re-sizes the subtrees below it.
+// Serial encoding only, which is all the nested tuple needs.
+class ResizingTupleValue: public values::DataValue {
+    array_ref<values::DataValue* const> _elements;
+
+    size_t encoded_head_size() const {
+        size_t total_size = 0;
+        for (auto e : _elements) {
+            total_size += e->is_dynamic() ? ETH_WORD_SIZE : e->encoded_size();
+        }
+        return total_size;
+    }
+
+public:
+    ResizingTupleValue(array_ref<values::DataValue* const> elements): _elements(elements) {}
+    bool is_dynamic() const override { return true; }
+    size_t encoded_size() const override {
+        size_t total_size = 0;
+        for (auto e : _elements) {
+            total_size += e->is_dynamic()
+                ? ETH_WORD_SIZE + e->encoded_size()
+                : e->encoded_size();
+        }
+        return total_size;
+    }
+    void encode_to(EncodeBuffer& buf) const override {
+        size_t head_pos = buf.pos();
+        auto data_buf = buf.view(head_pos + encoded_head_size());
+        for (auto e : _elements) {
+            if (e->is_dynamic()) {
+                write_word(buf, data_buf.pos() - head_pos);
+                e->encode_to(data_buf);
+            } else {
+                e->encode_to(buf);
+            }
+        }
+        buf.seek(data_buf.pos());
+    }
+};
+
+class ResizingArrayValue: public values::DataValue {
+    array_ref<values::DataValue* const> _elements;
+
+public:
+    ResizingArrayValue(array_ref<values::DataValue* const> elements): _elements(elements) {}
+    bool is_dynamic() const override { return true; }
+    size_t encoded_size() const override {
+        size_t total_size = (1 + _elements.size()) * ETH_WORD_SIZE;
+        for (auto e : _elements) {
+            total_size += e->encoded_size();
+        }
+        return total_size;
+    }
+    void encode_to(EncodeBuffer& buf) const override {
+        write_word(buf, _elements.size());
+        size_t head_pos = buf.pos();
+        auto data_buf = buf.view(head_pos + _elements.size() * ETH_WORD_SIZE);
+        for (auto e : _elements) {
+            write_word(buf, data_buf.pos() - head_pos);
+            e->encode_to(data_buf);
+        }
+        buf.seek(data_buf.pos());
+    }
+};
+
+// A tuple nesting `levels` deep: each level is `((uint256,uint256),bytes,T[])`
+// with `fanout` elements in the array of the next level.
+template <class TTuple, class TArray>
+values::DataValue* make_nested_tuple(
+    values::ValueStore& store,
+    const buf_t& payload,
+    size_t levels,
+    size_t fanout
+) {
+    using namespace values;
+    auto pair = store.make_array<DataValue*>(2);
+    pair[0] = store.make<Uint256Value>(uint256_t(levels));
+    pair[1] = store.make<Uint256Value>(uint256_t(fanout));
+    auto children = store.make_array<DataValue*>(levels > 1 ? fanout : 0);
+    for (size_t i = 0; i < children.size(); ++i) {
+        children[i] = make_nested_tuple<TTuple, TArray>(store, payload, levels - 1, fanout);
+    }
+    auto fields = store.make_array<DataValue*>(3);
+    fields[0] = store.make<InlineStructValue>(pair);
+    fields[1] = store.make<BytesArrayValue>(array_ref<const byte>(payload.data(), payload.size()));
+    fields[2] = store.make<TArray>(children);
+    return store.make<TTuple>(fields);
+}
+
+// Sizing and then encoding a 6-level nested tuple, as `encode()` does, with
+// sizes memoized at construction vs. re-summed on every call.
+void bench_nested_tuple() {
+    using namespace values;
+    values::ValueStore store;
+    buf_t payload(40, byte(0xab));
+    auto resizing = make_nested_tuple<ResizingTupleValue, ResizingArrayValue>(store, payload, 6, 4);
+    auto memoized = make_nested_tuple<MixedStructValue, DynamicRefArrayValue<DataValue>>(store, payload, 6, 4);
+    auto tree_words = memoized->encoded_size() / ETH_WORD_SIZE;
+    printf("nested tuple (6 levels, %zu words)\n", tree_words);
+    auto encode_tree = [&](DataValue* root) {
+        return [&, root](EncodeBuffer& buf, size_t i) {
+            if (i % tree_words == 0 && i + tree_words <= NUM_WORDS) {
+                auto size = root->encoded_size();
+                auto view = buf.view(buf.pos());
+                root->encode_to(view);
+                buf.seek(buf.pos() + size);
+            }
+        };
+    };
+    auto slow = bench("  sizes re-summed", encode_tree(resizing));
+    auto fast = bench("  sizes memoized", encode_tree(memoized));
+    printf("  speedup: %.1fx\n", slow / fast);
+}
+
+// Building and encoding 10k `(uint256,address)` tuples as a node per
+// element and leaf vs. as one block of words. This times the two value
+// representations only: `encode()` fills the block with `write_static()`
+// as it reads JS values, which the hand-written copies here stand in for
+// (see `src/bench.js` for the whole path).
+void bench_static_tuples() {
+    using namespace values;
+    const size_t n = 10000;
+    mt19937_64 rng(0x5eed);
+    vector<uint256_t> numbers(n);
+    buf_t addresses(n * 20);
+    for (size_t i = 0; i < n; ++i) {
+        numbers[i] = (uint256_t(rng()) << 192) | uint256_t(rng());
+    }
+    for (auto& b : addresses) {
+        b = byte(rng());
+    }
+    const size_t tree_words = 1 + n * 2;
+    printf("(uint256,address)[] (10k elements)\n");
+    auto slow = bench("  node per value", [&](EncodeBuffer& buf, size_t i) {
+        if (i % tree_words == 0 && i + tree_words <= NUM_WORDS) {
+            ValueStore store;
+            auto elements = store.make_array<DataValue*>(n);
+            for (size_t j = 0; j < n; ++j) {
+                auto fields = store.make_array<DataValue*>(2);
+                fields[0] = store.make<Uint256Value>(numbers[j]);
+                fields[1] = store.make<AddressValue>(addresses.data() + j * 20);
+                elements[j] = store.make<InlineStructValue>(fields);
+            }
+            store.make<DynamicInlineArrayValue<DataValue>>(elements)->encode_to(buf);
+        }
+    });
+    auto fast = bench("  one block of words", [&](EncodeBuffer& buf, size_t i) {
+        if (i % tree_words == 0 && i + tree_words <= NUM_WORDS) {
+            ValueStore store;
+            auto words = store.make_array<byte>(n * 2 * ETH_WORD_SIZE);
+            EncodeBuffer words_buf(words.data(), words.size());
+            for (size_t j = 0; j < n; ++j) {
+                write_word(words_buf, numbers[j]);
+                auto p = words_buf.advance(ETH_WORD_SIZE);
+                memset(p, 0, ETH_WORD_SIZE - 20);
+                memcpy(p + ETH_WORD_SIZE - 20, addresses.data() + j * 20, 20);
+            }
+            store.make<DynamicWordsArrayValue>(words, n)->encode_to(buf);
+        }
+    });
+    printf("  speedup: %.1fx\n", slow / fast);
+}
+
+int main() {
+    bench_write_word();
+    bench_pad_words();
+    bench_widen_uint_words<uint8_t>("uint8");
+    bench_widen_uint_words<uint32_t>("uint32");
+    bench_widen_uint_words<uint64_t>("uint64");
+    bench_write_bytes();
+    bench_validate_utf8();
+    bench_nested_tuple();
+    bench_static_tuples();
+    return 0;
+}
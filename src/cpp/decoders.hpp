@@ -0,0 +1,331 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "encoders.hpp"
+#include "plan.hpp"
+#include "utf8.hpp"
+
+namespace decoder {
+    using namespace std;
+    using encoder::ETH_WORD_SIZE;
+
+    class decode_error: public runtime_error {
+    public:
+        decode_error(const string& what): runtime_error(what) {}
+    };
+
+    inline uint64_t load_be64(const byte* p) {
+        uint64_t n;
+        memcpy(&n, p, sizeof(n));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        n = __builtin_bswap64(n);
+#endif
+        return n;
+    }
+
+    // Splits a word into 64-bit limbs, least significant first.
+    inline void load_limbs(const byte* word, uint64_t limbs[4]) {
+        for (size_t i = 0; i < 4; ++i) {
+            limbs[i] = load_be64(word + ETH_WORD_SIZE - (i + 1) * 8);
+        }
+    }
+
+    // Whether `n` bytes starting at `p` all equal `b`.
+    inline bool is_filled(const byte* p, size_t n, byte b) {
+        for (size_t i = 0; i < n; ++i) {
+            if (p[i] != b) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Bounds-checked reads from an encoded buffer.
+    class DecodeBuffer {
+    private:
+        const byte* _data;
+        size_t _size;
+        // Offsets can alias, so nested arrays can point again and again at
+        // the same data and decode far more than the buffer holds. Decoders
+        // charge each array element and each word of bytes and strings
+        // against this, one per input byte. Data without aliasing takes at
+        // least a word for each, so only arrays of empty tuples can run
+        // out without aliasing.
+        mutable size_t _budget;
+
+    public:
+        DecodeBuffer(const byte* data, size_t size): _data(data), _size(size), _budget(size) {}
+        size_t size() const { return _size; }
+        void charge(size_t n) const {
+            if (n > _budget) {
+                throw decode_error("too much data decoded; are offsets aliased?");
+            }
+            _budget -= n;
+        }
+        const byte* bytes(size_t pos, size_t n) const {
+            if (pos > _size || n > _size - pos) {
+                throw decode_error("data out of bounds");
+            }
+            return _data + pos;
+        }
+        const byte* word(size_t pos) const {
+            return bytes(pos, ETH_WORD_SIZE);
+        }
+        // Reads an offset or length, which can never exceed the buffer size.
+        size_t read_size(size_t pos) const {
+            auto w = word(pos);
+            if (!is_filled(w, ETH_WORD_SIZE - 8, byte(0))) {
+                throw decode_error("offset or length out of bounds");
+            }
+            auto n = load_be64(w + ETH_WORD_SIZE - 8);
+            if (n > _size) {
+                throw decode_error("offset or length out of bounds");
+            }
+            return size_t(n);
+        }
+    };
+
+    // Throws unless the padding of a static word is clean: zeros above
+    // unsigned integers, addresses and bools (which are also 0 or 1), sign
+    // bits above signed integers, and zeros after `bytesN`. `size` is as in
+    // `plan::Node`. `signature()` names the type in the error.
+    template <class TSignature>
+    void check_static_word(
+        const byte* w,
+        encoder::plan::Op op,
+        unsigned size,
+        TSignature signature
+    ) {
+        typedef encoder::plan::Op Op;
+        switch (op) {
+            case Op::Uint:
+            case Op::Address:
+            case Op::Bool: {
+                // Everything above the value's width must be zero.
+                auto bits = op == Op::Uint ? size : op == Op::Address ? 160 : 8;
+                auto high_bytes = ETH_WORD_SIZE - bits / 8;
+                if (!is_filled(w, high_bytes, byte(0))
+                        || (op == Op::Bool && unsigned(w[31]) > 1)) {
+                    throw decode_error("dirty high bits for " + signature());
+                }
+                break;
+            }
+            case Op::Int: {
+                // Everything above the value's width must be sign bits.
+                auto high_bytes = ETH_WORD_SIZE - size / 8;
+                auto sign = (unsigned(w[high_bytes]) & 0x80) ? byte(0xFF) : byte(0);
+                if (!is_filled(w, high_bytes, sign)) {
+                    throw decode_error("dirty high bits for " + signature());
+                }
+                break;
+            }
+            case Op::FixedBytes:
+                if (!is_filled(w + size, ETH_WORD_SIZE - size, byte(0))) {
+                    throw decode_error("dirty low bits for " + signature());
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Walks a plan over encoded data, handing decoded values to `TBuilder`.
+    // Mirrors `encoder::values`: static values are read inline from a head
+    // slot (`InlineListValue`), dynamic values are found by following the
+    // slot's offset from the start of the enclosing list (`RefListValue`),
+    // and dynamic arrays, bytes and strings are prefixed with their length.
+    //
+    // `TBuilder` provides `value_type` and:
+    //   value_type uint_value(const byte* word, unsigned bits)
+    //   value_type int_value(const byte* word, unsigned bits)
+    //   value_type bool_value(bool v)
+    //   value_type address_value(const byte* address)
+    //   value_type bytes_value(const byte* data, size_t size, bool is_fixed)
+    //   value_type string_value(const byte* utf8, size_t size)
+    //   value_type make_array(size_t length)
+    //   void set_element(value_type& arr, size_t i, value_type v)
+    //   value_type make_tuple(const plan::Node& type)
+    //   void set_field(value_type& t, size_t i, const plan::Field& f, value_type v)
+    template <class TBuilder>
+    class Decoder {
+    private:
+        typedef typename TBuilder::value_type value_t;
+        typedef encoder::plan::Op Op;
+
+        const encoder::plan::Plan& _plan;
+        TBuilder& _builder;
+        DecodeBuffer _buf;
+
+        const byte* read_static_word(const encoder::plan::Node& type, size_t pos) {
+            auto w = _buf.word(pos);
+            check_static_word(w, type.op, type.size, [&] { return type.signature; });
+            return w;
+        }
+
+        // Decodes a value from its slot in the head of a list at `base`.
+        value_t decode_slot(
+            const encoder::plan::Node& type,
+            size_t base,
+            size_t pos
+        ) {
+            if (type.is_dynamic) {
+                return decode_at(type, base + _buf.read_size(pos));
+            }
+            return decode_at(type, pos);
+        }
+
+        value_t decode_elements(
+            const encoder::plan::Node& type,
+            size_t length,
+            size_t base
+        ) {
+            const auto& element = _plan.node(type.element);
+            // Reject lengths the data can't possibly hold before allocating.
+            if (element.head_size && length > _buf.size() / element.head_size) {
+                throw decode_error("array length out of bounds");
+            }
+            _buf.bytes(base, length * element.head_size);
+            _buf.charge(length);
+            auto arr = _builder.make_array(length);
+            for (size_t i = 0; i < length; ++i) {
+                _builder.set_element(
+                    arr,
+                    i,
+                    decode_slot(element, base, base + i * element.head_size)
+                );
+            }
+            return arr;
+        }
+
+        value_t decode_fields(const encoder::plan::Node& type, size_t base) {
+            auto t = _builder.make_tuple(type);
+            for (size_t i = 0; i < type.field_count; ++i) {
+                const auto& field = _plan.field(type, i);
+                _builder.set_field(
+                    t,
+                    i,
+                    field,
+                    decode_slot(_plan.node(field.node), base, base + field.head_offset)
+                );
+            }
+            return t;
+        }
+
+    public:
+        Decoder(
+            const encoder::plan::Plan& plan,
+            TBuilder& builder,
+            const byte* data,
+            size_t size
+        ): _plan(plan), _builder(builder), _buf(data, size) {}
+
+        value_t decode() {
+            return decode_at(_plan.root(), 0);
+        }
+
+        // Decodes a value whose encoding starts at `pos`.
+        value_t decode_at(const encoder::plan::Node& type, size_t pos) {
+            switch (type.op) {
+                case Op::Uint:
+                    return _builder.uint_value(read_static_word(type, pos), type.size);
+                case Op::Int:
+                    return _builder.int_value(read_static_word(type, pos), type.size);
+                case Op::Bool:
+                    return _builder.bool_value(read_static_word(type, pos)[31] != byte(0));
+                case Op::Address:
+                    return _builder.address_value(read_static_word(type, pos) + 12);
+                case Op::FixedBytes:
+                    return _builder.bytes_value(
+                        read_static_word(type, pos),
+                        type.size,
+                        true
+                    );
+                case Op::Bytes: {
+                    auto size = _buf.read_size(pos);
+                    auto data = _buf.bytes(pos + ETH_WORD_SIZE, size);
+                    _buf.charge(size / ETH_WORD_SIZE);
+                    return _builder.bytes_value(data, size, false);
+                }
+                case Op::String: {
+                    auto size = _buf.read_size(pos);
+                    auto data = _buf.bytes(pos + ETH_WORD_SIZE, size);
+                    _buf.charge(size / ETH_WORD_SIZE);
+                    if (!utf8::is_valid(data, size)) {
+                        throw decode_error("invalid UTF-8 in string");
+                    }
+                    return _builder.string_value(data, size);
+                }
+                case Op::InlineTuple:
+                case Op::RefTuple:
+                case Op::MixedTuple:
+                    return decode_fields(type, pos);
+                case Op::FixedUintArray:
+                case Op::FixedInlineArray:
+                case Op::FixedRefArray:
+                    return decode_elements(type, type.length, pos);
+                case Op::DynamicUintArray:
+                case Op::DynamicInlineArray:
+                case Op::DynamicRefArray:
+                    return decode_elements(
+                        type,
+                        _buf.read_size(pos),
+                        pos + ETH_WORD_SIZE
+                    );
+            }
+            throw logic_error("unknown plan op");
+        }
+
+        // Number of fields or elements of the tuple or array at `pos`.
+        size_t length_at(const encoder::plan::Node& type, size_t pos) {
+            switch (type.op) {
+                case Op::InlineTuple:
+                case Op::RefTuple:
+                case Op::MixedTuple:
+                    return type.field_count;
+                case Op::DynamicUintArray:
+                case Op::DynamicInlineArray:
+                case Op::DynamicRefArray:
+                    return _buf.read_size(pos);
+                default:
+                    return type.length;
+            }
+        }
+
+        const encoder::plan::Node& child_type(
+            const encoder::plan::Node& type,
+            size_t i
+        ) const {
+            if (type.field_count) {
+                return _plan.node(_plan.field(type, i).node);
+            }
+            return _plan.node(type.element);
+        }
+
+        // Where the encoding of field or element `i` of the tuple or array at
+        // `pos` starts, following its offset if it is dynamic.
+        size_t child_at(const encoder::plan::Node& type, size_t pos, size_t i) {
+            const auto& child = child_type(type, i);
+            size_t base = pos;
+            size_t slot;
+            if (type.field_count) {
+                slot = base + _plan.field(type, i).head_offset;
+            } else {
+                if (type.op == Op::DynamicUintArray
+                        || type.op == Op::DynamicInlineArray
+                        || type.op == Op::DynamicRefArray) {
+                    base += ETH_WORD_SIZE;
+                }
+                slot = base + i * child.head_size;
+            }
+            if (child.is_dynamic) {
+                return base + _buf.read_size(slot);
+            }
+            _buf.bytes(slot, child.head_size);
+            return slot;
+        }
+    };
+}
@@ -1,9 +1,20 @@
+#pragma once
 #include <string>
 #include <vector>
+#include <memory>
 #include <cstddef>
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
 #include <algorithm>
 #include <numeric>
+#include <thread>
+#include <stdexcept>
 #include "num.hpp"
+#include "kernels.hpp"
+#include "arena.hpp"
+#include "workers.hpp"
 
 namespace encoder {
     using namespace std;
@@ -12,55 +23,178 @@ namespace encoder {
     typedef byte bytes32_t[32];
     static const size_t ETH_WORD_SIZE = 32;
 
+    // Writes into caller-provided memory with `memcpy`/`memset`, so writes
+    // never allocate. Unchecked buffers are raw pointers into memory sized
+    // up front for the whole encoding (see `DataValue::encoded_size()`) and
+    // only assert in debug builds; checked buffers throw `out_of_range`
+    // instead of overrunning memory whose size wasn't precomputed.
     class EncodeBuffer {
     private:
-        buf_t& _buf;
+        byte* _data;
+        size_t _size;
         size_t _pos;
+        // Threads large lists may use to encode their elements.
+        unsigned _threads;
+        bool _checked;
+
+        void reserve(size_t n) const {
+            if (_checked && n > _size - _pos) {
+                throw out_of_range("encode buffer overflow");
+            }
+            assert(n <= _size - _pos);
+        }
 
     public:
-        EncodeBuffer(buf_t& buf, size_t pos): _buf(buf), _pos(pos) {}
+        EncodeBuffer(
+            byte* data,
+            size_t size,
+            size_t pos = 0,
+            unsigned threads = 1,
+            bool checked = false
+        ): _data(data), _size(size), _pos(pos), _threads(threads), _checked(checked) {}
+        static EncodeBuffer checked(byte* data, size_t size) {
+            return EncodeBuffer(data, size, 0, 1, true);
+        }
         size_t pos() const { return _pos; }
-        const buf_t& buffer() const { return _buf; }
-        void reserve(size_t needed) {
-            _buf.resize(_pos + needed);
+        size_t size() const { return _size; }
+        const byte* data() const { return _data; }
+        unsigned threads() const { return _threads; }
+        bool is_checked() const { return _checked; }
+        void seek(size_t pos) {
+            if (_checked && pos > _size) {
+                throw out_of_range("encode buffer overflow");
+            }
+            assert(pos <= _size);
+            _pos = pos;
         }
         void write(const byte* start, const byte* end) {
-            reserve(size_t(end - start));
-            for (auto p = start; p != end; ++p) {
-                _buf[_pos++] = *p;
+            auto n = size_t(end - start);
+            reserve(n);
+            if (n) {
+                memcpy(_data + _pos, start, n);
+            }
+            _pos += n;
+        }
+        void fill(byte b, size_t n) {
+            reserve(n);
+            memset(_data + _pos, int(b), n);
+            _pos += n;
+        }
+        // Claims the next `size` bytes for the caller to fill in directly.
+        byte* advance(size_t size) {
+            reserve(size);
+            auto p = _data + _pos;
+            _pos += size;
+            return p;
+        }
+        EncodeBuffer view(size_t pos, unsigned threads) const {
+            if (_checked && pos > _size) {
+                throw out_of_range("encode buffer overflow");
+            }
+            assert(pos <= _size);
+            return EncodeBuffer(_data, _size, pos, threads, _checked);
+        }
+        EncodeBuffer view(size_t pos) const {
+            return view(pos, _threads);
+        }
+    };
+
+    // Output that grows as it is appended to, for encoding without sizing
+    // anything first. Positions stay valid as it grows but pointers don't,
+    // so an `EncodeBuffer` from `append()` or `at()` must be done with
+    // before the next `append()`.
+    class GrowableBuffer {
+    private:
+        buf_t _data;
+        size_t _size = 0;
+        // Whether a `Lease` has this thread's buffer.
+        bool _leased = false;
+
+    public:
+        // Clearing frees capacity beyond this, so one huge encode doesn't pin
+        // its memory forever.
+        static constexpr size_t MAX_RETAINED_SIZE = 16 * 1024 * 1024;
+
+        GrowableBuffer(size_t capacity = 0): _data(capacity) {}
+        GrowableBuffer(const GrowableBuffer&) = delete;
+        GrowableBuffer& operator=(const GrowableBuffer&) = delete;
+
+        // One buffer per thread, reused across encodes on that thread. Take
+        // it with a `Lease`.
+        static GrowableBuffer& for_this_thread() {
+            thread_local GrowableBuffer buf(1024);
+            return buf;
+        }
+
+        // This thread's buffer, cleared, for one encode. Encodes can nest
+        // (a JS getter or proxy can start one in the middle of another), and
+        // a nested one gets a buffer of its own, since appending to the
+        // outer one's would move or overwrite what it is writing.
+        class Lease {
+        private:
+            GrowableBuffer& _shared = for_this_thread();
+            unique_ptr<GrowableBuffer> _nested;
+
+        public:
+            Lease() {
+                if (_shared._leased) {
+                    _nested.reset(new GrowableBuffer(1024));
+                } else {
+                    _shared._leased = true;
+                    _shared.clear();
+                }
+            }
+            ~Lease() {
+                if (!_nested) {
+                    _shared._leased = false;
+                }
             }
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+
+            GrowableBuffer& operator*() { return _nested ? *_nested : _shared; }
+        };
+
+        size_t size() const { return _size; }
+        const byte* data() const { return _data.data(); }
+        // Claims `n` bytes at the end, returning a buffer for writing them.
+        EncodeBuffer append(size_t n) {
+            if (_data.size() - _size < n) {
+                _data.resize(max(_size + n, _data.size() * 2));
+            }
+            EncodeBuffer buf(_data.data(), _size + n, _size);
+            _size += n;
+            return buf;
+        }
+        // A buffer for (re)writing the `n` claimed bytes at `pos`.
+        EncodeBuffer at(size_t pos, size_t n) {
+            assert(pos <= _size && n <= _size - pos);
+            return EncodeBuffer(_data.data(), pos + n, pos);
         }
-        EncodeBuffer view(size_t pos) {
-            if (pos > _pos) {
-                reserve(pos - _pos);
+        void clear() {
+            _size = 0;
+            if (_data.size() > MAX_RETAINED_SIZE) {
+                buf_t(MAX_RETAINED_SIZE).swap(_data);
             }
-            return EncodeBuffer(_buf, pos);
         }
     };
 
-    size_t align_size(size_t s) {
+    inline size_t align_size(size_t s) {
         if (s % ETH_WORD_SIZE) {
             return s + (ETH_WORD_SIZE - (s % ETH_WORD_SIZE));
         }
         return s;
     }
 
-    void write_aligned_bytes(
+    // The bytes followed by zeroes up to the next word boundary.
+    inline void write_aligned_bytes(
         EncodeBuffer& buf,
         const byte* start,
         const byte* end
     ) {
-        static const byte* filler_bytes = (const byte*)
-            "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
-            "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00";
-        auto size = size_t(end) - size_t(start);
-        auto aligned_size = align_size(size);
-        auto fill_size = aligned_size - size;
+        auto size = size_t(end - start);
         buf.write(start, end);
-        buf.write(
-            (const byte*) &filler_bytes,
-            (const byte*) &filler_bytes + fill_size
-        );
+        buf.fill(byte(0), align_size(size) - size);
     }
 
     template <class TIterator>
@@ -72,23 +206,184 @@ namespace encoder {
         return write_aligned_bytes(buf, &*start, &*end);
     }
 
+    inline void store_be64(byte* p, uint64_t n) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        n = __builtin_bswap64(n);
+#endif
+        memcpy(p, &n, sizeof(n));
+    }
+
+    // Works for any type convertible to uint256_t, one byte at a time.
     template <class TIntType>
-    void write_word(EncodeBuffer& buf, TIntType n) {
+    void write_word_generic(EncodeBuffer& buf, TIntType n) {
         auto w = uint256_t(n);
         byte word_bytes[ETH_WORD_SIZE];
         for (size_t i = 0; i < ETH_WORD_SIZE; ++i) {
             word_bytes[ETH_WORD_SIZE - i - 1] = byte(unsigned(w & 0xFF));
-            w = w >> 0xFF;
+            w = w >> 8;
         }
         assert(w == 0);
         buf.write((const byte*) &word_bytes, (const byte*) &word_bytes + ETH_WORD_SIZE);
     }
 
+    template <class TIntType>
+    typename enable_if<!is_integral<TIntType>::value>::type
+    write_word(EncodeBuffer& buf, const TIntType& n) {
+        write_word_generic(buf, n);
+    }
+
+    // Native unsigned integers (lengths, offsets): zero the high 24 bytes and
+    // store the rest with one byte swap.
+    template <class TUint>
+    typename enable_if<is_unsigned<TUint>::value && sizeof(TUint) <= 8>::type
+    write_word(EncodeBuffer& buf, TUint n) {
+        auto p = buf.advance(ETH_WORD_SIZE);
+        memset(p, 0, ETH_WORD_SIZE - 8);
+        store_be64(p + ETH_WORD_SIZE - 8, uint64_t(n));
+    }
+
+    // Native signed integers: sign-extend in one pass by filling the high 24
+    // bytes with 0xFF or 0x00 (a constant-size memset, which compilers emit
+    // as a broadcast and vector stores) and byte-swapping the low 8 bytes,
+    // which already hold the two's complement.
+    template <class TInt>
+    typename enable_if<is_integral<TInt>::value && is_signed<TInt>::value && sizeof(TInt) <= 8>::type
+    write_word(EncodeBuffer& buf, TInt n) {
+        auto p = buf.advance(ETH_WORD_SIZE);
+        memset(p, n < 0 ? 0xFF : 0, ETH_WORD_SIZE - 8);
+        store_be64(p + ETH_WORD_SIZE - 8, uint64_t(int64_t(n)));
+    }
+
+    // 128-bit natives: extend into the high 16 bytes and store both halves.
+    inline void write_word(EncodeBuffer& buf, unsigned __int128 n) {
+        auto p = buf.advance(ETH_WORD_SIZE);
+        memset(p, 0, ETH_WORD_SIZE - 16);
+        store_be64(p + ETH_WORD_SIZE - 16, uint64_t(n >> 64));
+        store_be64(p + ETH_WORD_SIZE - 8, uint64_t(n));
+    }
+
+    inline void write_word(EncodeBuffer& buf, __int128 n) {
+        auto p = buf.advance(ETH_WORD_SIZE);
+        memset(p, n < 0 ? 0xFF : 0, ETH_WORD_SIZE - 16);
+        store_be64(p + ETH_WORD_SIZE - 16, uint64_t((unsigned __int128) n >> 64));
+        store_be64(p + ETH_WORD_SIZE - 8, uint64_t(n));
+    }
+
+    // Stores the limbs straight into the word; signed values are already
+    // two's complement, so they come out sign-extended.
+    template <bool TSigned>
+    inline void write_word(EncodeBuffer& buf, const num::wide_int<TSigned>& n) {
+        n.store_be(buf.advance(ETH_WORD_SIZE));
+    }
+
     namespace values {
         class DataValue {
         public:
+            virtual ~DataValue() {}
+            // Whether the value is encoded out-of-line (behind an offset)
+            // when it is an element of a tuple or array.
+            virtual bool is_dynamic() const = 0;
             virtual size_t encoded_size() const = 0;
-            virtual void encode_to(EncodeBuffer& buf, size_t prefix_size = 0) const = 0;
+            // Writes exactly `encoded_size()` bytes at the buffer position and
+            // leaves the buffer positioned after them.
+            virtual void encode_to(EncodeBuffer& buf) const = 0;
+            // Size in the non-standard packed encoding (`abi.encodePacked`).
+            // Static values inside arrays are still padded to words there,
+            // so by default this is the standard encoding.
+            virtual size_t packed_size() const { return encoded_size(); }
+            virtual void encode_packed_to(EncodeBuffer& buf) const {
+                encode_to(buf);
+            }
+        };
+
+        // Lists shorter than this are always encoded on one thread.
+        static const size_t PARALLEL_MIN_ELEMENTS = 1024;
+
+        inline bool should_encode_parallel(
+            const EncodeBuffer& buf,
+            array_ref<DataValue* const> elements
+        ) {
+            return buf.threads() > 1 && elements.size() >= PARALLEL_MIN_ELEMENTS;
+        }
+
+        // Encodes each element at its precomputed position, splitting the
+        // elements into contiguous ranges across `buf.threads()` threads:
+        // this one and workers from the shared pool. Positions must not
+        // overlap, so each thread writes a disjoint region.
+        inline void encode_parallel(
+            const EncodeBuffer& buf,
+            array_ref<DataValue* const> elements,
+            const vector<size_t>& positions
+        ) {
+            size_t n = elements.size();
+            size_t num_threads = min(size_t(buf.threads()), n);
+            size_t per_thread = (n + num_threads - 1) / num_threads;
+            auto encode_range = [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    // Nested lists stay on this thread.
+                    auto element_buf = buf.view(positions[i], 1);
+                    elements[i]->encode_to(element_buf);
+                }
+            };
+            WorkerPool::shared().run(num_threads, [&](size_t t) {
+                auto begin = min(t * per_thread, n);
+                encode_range(begin, min(begin + per_thread, n));
+            });
+        }
+
+        // Allocates the values of a tree, and the arrays they point to, from
+        // an arena, so building a tree costs no heap allocations once the
+        // arena is warm and the whole tree is freed at once when the store
+        // is destroyed. Values never have their destructors run, so they
+        // keep everything they own in the arena (or in borrowed memory).
+        class ValueStore {
+        private:
+            Arena& _arena;
+            Arena::Mark _mark;
+            // Whether values may point into caller memory that stays alive
+            // and unchanged until encoding is done (e.g., JS typed arrays
+            // during a synchronous call). Otherwise they must copy it.
+            bool _can_borrow;
+            // Whether values may read their source (e.g., a JS string) only
+            // when encoded, which needs encoding to run on the calling
+            // thread, during the call.
+            bool _can_defer;
+
+        public:
+            // Uses the calling thread's arena.
+            ValueStore(bool can_borrow = true, bool can_defer = false)
+                : ValueStore(Arena::for_this_thread(), can_borrow, can_defer) {}
+            ValueStore(Arena& arena, bool can_borrow = true, bool can_defer = false)
+                : _arena(arena),
+                _mark(arena.mark()),
+                _can_borrow(can_borrow),
+                _can_defer(can_defer) {}
+            ValueStore(const ValueStore&) = delete;
+            ValueStore& operator=(const ValueStore&) = delete;
+            // Stores on one arena must be destroyed in reverse order.
+            ~ValueStore() {
+                _arena.rewind(_mark);
+            }
+            bool can_borrow() const { return _can_borrow; }
+            bool can_defer() const { return _can_defer; }
+
+            template <class TValue, typename... TArgs>
+            TValue* make(TArgs&&... args) {
+                static_assert(is_base_of<DataValue, TValue>::value, "expected a DataValue");
+                return _arena.make<TValue>(std::forward<TArgs>(args)...);
+            }
+            template <class T>
+            array_ref<T> make_array(size_t n) {
+                return _arena.make_array<T>(n);
+            }
+            template <class T>
+            array_ref<T> copy_array(const T* data, size_t n) {
+                return _arena.copy_array(data, n);
+            }
+            // Child list for a list value.
+            array_ref<DataValue*> list(const vector<DataValue*>& elements) {
+                return copy_array(elements.data(), elements.size());
+            }
         };
 
         template <class TValue>
@@ -96,58 +391,168 @@ namespace encoder {
         private:
             TValue _v;
 
+            // Width of the ABI type in bytes (e.g., 14 for `uint112`).
+            size_t _width;
+
         public:
-            NumericValue(const TValue& v): _v(v) {}
+            NumericValue(const TValue& v, size_t width = ETH_WORD_SIZE)
+                : _v(v), _width(width) {}
+            bool is_dynamic() const override { return false; }
             size_t encoded_size() const override { return ETH_WORD_SIZE; };
             void encode_to(EncodeBuffer& buf) const override {
-                write_word(_v, buf);
+                write_word(buf, _v);
+            }
+            size_t packed_size() const override { return _width; }
+            // The low `_width` bytes of the (sign-extended) word.
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                byte word[ETH_WORD_SIZE];
+                EncodeBuffer word_buf(word, ETH_WORD_SIZE);
+                write_word(word_buf, _v);
+                buf.write(word + ETH_WORD_SIZE - _width, word + ETH_WORD_SIZE);
             }
         };
 
         typedef NumericValue<uint256_t> Uint256Value;
         typedef NumericValue<int256_t> Int256Value;
-        typedef NumericValue<bytes32_t> Bytes32Value;
 
+        // A `uintN`/`intN` held in the narrowest native type with at least
+        // N bits (see `num::int_t`), so e.g. `uint8` never touches 256-bit
+        // arithmetic. The range is checked once, at construction.
+        template <unsigned TBits, bool TSigned>
+        class IntValue: public NumericValue<num::int_t<TBits, TSigned>> {
+            static_assert(TBits % 8 == 0 && TBits >= 8 && TBits <= 256, "invalid integer width");
+
+        public:
+            typedef num::int_t<TBits, TSigned> value_type;
+
+            IntValue(const value_type& v)
+                : NumericValue<value_type>(check(v), TBits / 8) {}
+
+            static const value_type& check(const value_type& v) {
+                if (!num::fits_bits<TBits>(v)) {
+                    throw invalid_argument(
+                        "value out of range for " + string(TSigned ? "int" : "uint")
+                            + to_string(TBits)
+                    );
+                }
+                return v;
+            }
+        };
+
+        // bytes1..bytes32, right-padded to a full word.
+        class FixedBytesValue: public DataValue {
+        private:
+            bytes32_t _bytes;
+            size_t _size;
+
+        public:
+            FixedBytesValue(const byte* start, const byte* end)
+                    : _size(size_t(end - start)) {
+                assert(_size <= ETH_WORD_SIZE);
+                copy(start, end, _bytes);
+            }
+            bool is_dynamic() const override { return false; }
+            size_t encoded_size() const override { return ETH_WORD_SIZE; }
+            void encode_to(EncodeBuffer& buf) const override {
+                write_aligned_bytes(buf, _bytes, _bytes + _size);
+            }
+            size_t packed_size() const override { return _size; }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                buf.write(_bytes, _bytes + _size);
+            }
+        };
+
+        // A 20-byte address, left-padded to a full word.
+        class AddressValue: public DataValue {
+        private:
+            byte _address[20];
+
+        public:
+            AddressValue(const byte* address) {
+                copy(address, address + sizeof(_address), _address);
+            }
+            bool is_dynamic() const override { return false; }
+            size_t encoded_size() const override { return ETH_WORD_SIZE; }
+            void encode_to(EncodeBuffer& buf) const override {
+                auto p = buf.advance(ETH_WORD_SIZE);
+                memset(p, 0, ETH_WORD_SIZE - sizeof(_address));
+                copy(_address, _address + sizeof(_address), p + ETH_WORD_SIZE - sizeof(_address));
+            }
+            size_t packed_size() const override { return sizeof(_address); }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                buf.write(_address, _address + sizeof(_address));
+            }
+        };
+
+        // `bytes`, over bytes in the store's arena or borrowed memory.
         class BytesArrayValue: public DataValue {
         private:
-            buf_t _bytes;
+            array_ref<const byte> _bytes;
 
         public:
-            BytesArrayValue(const buf_t& v): _bytes(v) {}
+            BytesArrayValue(array_ref<const byte> v): _bytes(v) {}
+            bool is_dynamic() const override { return true; }
             size_t encoded_size() const override {
                 return ETH_WORD_SIZE + align_size(_bytes.size());
             }
-            void encode_to(EncodeBuffer& buf, size_t) const override {
+            void encode_to(EncodeBuffer& buf) const override {
                 write_word(buf, _bytes.size());
-                write_aligned_bytes(buf, _bytes.cbegin(), _bytes.cend());
+                write_aligned_bytes(buf, _bytes.data(), _bytes.data() + _bytes.size());
+            }
+            // Just the bytes: no length and no padding.
+            size_t packed_size() const override { return _bytes.size(); }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                buf.write(_bytes.data(), _bytes.data() + _bytes.size());
             }
         };
 
-        class RefListValue: DataValue {
+        // `string`, over its UTF-8. Encodes exactly like `bytes`.
+        class StringValue: public BytesArrayValue {
+        public:
+            StringValue(array_ref<const byte> utf8): BytesArrayValue(utf8) {}
+        };
+
+        // Sum of the elements' encoded sizes.
+        inline size_t encoded_elements_size(array_ref<DataValue* const> elements) {
+            size_t total_size = 0;
+            for (auto i = elements.cbegin(); i != elements.cend(); ++i) {
+                total_size += (*i)->encoded_size();
+            }
+            return total_size;
+        }
+
+        // List values point to their elements through an arena array (see
+        // `ValueStore::make_array()` and `ValueStore::list()`). Elements are
+        // built before their list, so lists compute their size once, in the
+        // constructor, from their elements' already computed sizes. Sizing a
+        // tree is then linear however deeply it nests, and `encode_to()`
+        // can ask for element sizes for free.
+        class RefListValue: public DataValue {
         protected:
-            vector<DataValue*> _elements;
+            array_ref<DataValue* const> _elements;
+            size_t _encoded_size;
 
-            virtual size_t encoded_array_size() const {
+            size_t encoded_array_size() const {
                 return _elements.size() * ETH_WORD_SIZE;
             }
 
         public:
-            RefListValue(const vector<DataValue*>& elements):
-                _elements(elements) {}
-            size_t length() const { return _elements.size(); }
-            size_t encoded_size() const override {
-                auto total_size = encoded_array_size();
+            RefListValue(array_ref<DataValue* const> elements)
+                : _elements(elements),
                 // Data for each element will be appended at the end of the array.
-                for (auto i = _elements.cbegin(); i != _elements.cend(); ++i) {
-                    total_size += (*i)->encoded_size();
+                _encoded_size(encoded_array_size() + encoded_elements_size(elements)) {}
+            size_t length() const { return _elements.size(); }
+            bool is_dynamic() const override { return true; }
+            size_t encoded_size() const override { return _encoded_size; }
+            void encode_to(EncodeBuffer& buf) const override {
+                if (should_encode_parallel(buf, _elements)) {
+                    return encode_to_parallel(buf);
                 }
-                return total_size;
-            }
-            void encode_to(EncodeBuffer& buf, size_t prefix_size = 0) const override {
                 // Prepare a bufffer at the end of the array for element data.
                 size_t data_start = buf.pos() + encoded_array_size();
                 auto data_buf = buf.view(data_start);
-                size_t head_pos = buf.pos() - prefix_size;
+                // Offsets are relative to the start of the list.
+                size_t head_pos = buf.pos();
                 // Write elements.
                 for (size_t i = 0; i < _elements.size(); ++i) {
                     auto e = _elements[i];
@@ -156,53 +561,68 @@ namespace encoder {
                     // Write element data.
                     e->encode_to(data_buf);
                 }
+                buf.seek(data_buf.pos());
+            }
+            // Element sizes fix where each element's data goes, so the head
+            // can be written up front and the data encoded concurrently.
+            void encode_to_parallel(EncodeBuffer& buf) const {
+                size_t head_pos = buf.pos();
+                size_t data_pos = head_pos + encoded_array_size();
+                vector<size_t> positions(_elements.size());
+                for (size_t i = 0; i < _elements.size(); ++i) {
+                    write_word(buf, data_pos - head_pos);
+                    positions[i] = data_pos;
+                    data_pos += _elements[i]->encoded_size();
+                }
+                encode_parallel(buf, _elements, positions);
+                buf.seek(data_pos);
             }
         };
 
+        // Elements are all dynamic and of the same type, but their data can
+        // still differ in size (e.g., `bytes[]`), so there is no shortcut
+        // for `encoded_size()`.
         template <class TElementValue, typename TBase=RefListValue>
         class HomogeneousRefListValue: public TBase {
         public:
-            HomogeneousRefListValue(const vector<TElementValue*>& elements)
+            HomogeneousRefListValue(array_ref<DataValue* const> elements)
                 : TBase(elements) {}
-            size_t encoded_size() const override {
-                auto total_size = TBase::encoded_array_size();
-                // Data for each element will be appended at the end of the array.
-                if (TBase::_elements.size()) {
-                    // No need to check all elements because the list is homogeneous.
-                    total_size += TBase::_elements.size()
-                        * TBase::_elements[0]->encoded_size();
-                }
-                return total_size;
-            }
         };
 
         class InlineListValue : public DataValue {
         protected:
-            vector<DataValue*> _elements;
+            array_ref<DataValue* const> _elements;
+            // All data is inside the array.
+            size_t _encoded_size;
 
-            virtual size_t encoded_array_size() const {
-                size_t total_size = 0;
-                // Inline element values inside the array.
-                for (auto i = _elements.cbegin(); i != _elements.cend(); ++i) {
-                    total_size += (*i)->encoded_size();
-                }
-                return total_size;
-            }
+            InlineListValue(array_ref<DataValue* const> elements, size_t encoded_size)
+                : _elements(elements), _encoded_size(encoded_size) {}
 
         public:
-            InlineListValue(const vector<DataValue*>& elements)
-                : _elements(elements) {}
+            InlineListValue(array_ref<DataValue* const> elements)
+                : InlineListValue(elements, encoded_elements_size(elements)) {}
             size_t length() const { return _elements.size(); }
-            size_t encoded_size() const override {
-                // All data is inside the array.
-                return encoded_array_size();
-            }
-            void encode_to(EncodeBuffer& buf, size_t) const override {
+            bool is_dynamic() const override { return false; }
+            size_t encoded_size() const override { return _encoded_size; }
+            void encode_to(EncodeBuffer& buf) const override {
+                if (should_encode_parallel(buf, _elements)) {
+                    return encode_to_parallel(buf);
+                }
                 for (auto i = _elements.cbegin(); i != _elements.cend(); ++i) {
                     // Inline element data.
                     (*i)->encode_to(buf);
                 }
             }
+            void encode_to_parallel(EncodeBuffer& buf) const {
+                vector<size_t> positions(_elements.size());
+                size_t pos = buf.pos();
+                for (size_t i = 0; i < _elements.size(); ++i) {
+                    positions[i] = pos;
+                    pos += _elements[i]->encoded_size();
+                }
+                encode_parallel(buf, _elements, positions);
+                buf.seek(pos);
+            }
         };
 
         template <
@@ -211,20 +631,58 @@ namespace encoder {
         >
         class HomogeneousInlineListValue : public TBase {
         protected:
-            size_t encoded_array_size() const override {
-                // Inline element values inside the array.
-                if (TBase::_elements.size()) {
-                    // No need to check each element because the list is
-                    // homogeneous.
-                    return TBase::_elements[0]->encoded_size()
-                        * TBase::_elements.size();
-                }
-                return 0;
+            static size_t encoded_array_size(array_ref<DataValue* const> elements) {
+                // No need to check each element because the list is
+                // homogeneous.
+                return elements.empty()
+                    ? 0
+                    : elements[0]->encoded_size() * elements.size();
             }
 
         public:
-            HomogeneousInlineListValue(const vector<TElementValue*>& elements)
-                : TBase(elements) {}
+            HomogeneousInlineListValue(array_ref<DataValue* const> elements)
+                : TBase(elements, encoded_array_size(elements)) {}
+        };
+
+        // A tuple with both static and dynamic elements. Static elements are
+        // inlined in the head and dynamic elements are referenced by offset.
+        class MixedListValue: public DataValue {
+        protected:
+            array_ref<DataValue* const> _elements;
+            // Both memoized at construction, like `RefListValue`.
+            size_t _head_size = 0;
+            size_t _encoded_size = 0;
+
+        public:
+            MixedListValue(array_ref<DataValue* const> elements)
+                : _elements(elements) {
+                for (auto i = _elements.cbegin(); i != _elements.cend(); ++i) {
+                    auto size = (*i)->encoded_size();
+                    if ((*i)->is_dynamic()) {
+                        _head_size += ETH_WORD_SIZE;
+                        _encoded_size += ETH_WORD_SIZE + size;
+                    } else {
+                        _head_size += size;
+                        _encoded_size += size;
+                    }
+                }
+            }
+            size_t length() const { return _elements.size(); }
+            bool is_dynamic() const override { return true; }
+            size_t encoded_size() const override { return _encoded_size; }
+            void encode_to(EncodeBuffer& buf) const override {
+                size_t head_pos = buf.pos();
+                auto data_buf = buf.view(head_pos + _head_size);
+                for (auto i = _elements.cbegin(); i != _elements.cend(); ++i) {
+                    if ((*i)->is_dynamic()) {
+                        write_word(buf, data_buf.pos() - head_pos);
+                        (*i)->encode_to(data_buf);
+                    } else {
+                        (*i)->encode_to(buf);
+                    }
+                }
+                buf.seek(data_buf.pos());
+            }
         };
 
         template <
@@ -233,13 +691,20 @@ namespace encoder {
         >
         class DynamicRefArrayValue: public TBase {
         public:
-            DynamicRefArrayValue(const vector<TElementValue*>& v): TBase(v) {}
+            DynamicRefArrayValue(array_ref<DataValue* const> v): TBase(v) {}
             size_t encoded_size() const override {
                 return TBase::encoded_size() + ETH_WORD_SIZE;
             }
-            void encode_to(EncodeBuffer& buf, size_t) const override {
+            void encode_to(EncodeBuffer& buf) const override {
                 write_word(buf, TBase::length());
-                TBase::encode_to(buf, ETH_WORD_SIZE);
+                TBase::encode_to(buf);
+            }
+            // Packed arrays have no length prefix.
+            size_t packed_size() const override {
+                return TBase::encoded_size();
+            }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                TBase::encode_to(buf);
             }
         };
 
@@ -249,13 +714,21 @@ namespace encoder {
         >
         class DynamicInlineArrayValue: public TBase {
         public:
-            DynamicInlineArrayValue(const vector<TElementValue*>& v): TBase(v) {}
+            DynamicInlineArrayValue(array_ref<DataValue* const> v): TBase(v) {}
+            bool is_dynamic() const override { return true; }
             size_t encoded_size() const override {
                 return TBase::encoded_size() + ETH_WORD_SIZE;
             }
-            void encode_to(EncodeBuffer& buf, size_t) const override {
+            void encode_to(EncodeBuffer& buf) const override {
                 write_word(buf, TBase::length());
-                TBase::encode_to(buf, ETH_WORD_SIZE);
+                TBase::encode_to(buf);
+            }
+            // Packed arrays have no length prefix.
+            size_t packed_size() const override {
+                return TBase::encoded_size();
+            }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                TBase::encode_to(buf);
             }
         };
 
@@ -265,22 +738,43 @@ namespace encoder {
         template <class TElementValue>
         using FixedInlineArrayValue = HomogeneousInlineListValue<TElementValue>;
 
-        // Efficient version of DynamicInlineArrayValue for numeric elements only.
+        // Writes consecutive numbers as words, widening native unsigned
+        // integers in bulk.
+        template <class TNumeric>
+        void write_words(EncodeBuffer& buf, const TNumeric* numbers, size_t n) {
+            if constexpr (is_unsigned<TNumeric>::value && sizeof(TNumeric) <= 8) {
+                kernels::widen_uint_words(buf.advance(n * ETH_WORD_SIZE), numbers, n);
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    write_word(buf, numbers[i]);
+                }
+            }
+        }
+
+        // Efficient version of DynamicInlineArrayValue for numeric elements
+        // only, which are in the store's arena or borrowed (e.g., a typed
+        // array's backing store).
         template <class TNumeric>
         class DynamicNumericArrayValue: public DataValue {
         private:
-            vector<TNumeric> _numbers;
+            array_ref<const TNumeric> _numbers;
         public:
-            DynamicNumericArrayValue(const vector<TNumeric>& numbers)
+            DynamicNumericArrayValue(array_ref<const TNumeric> numbers)
                 : _numbers(numbers) {}
+            bool is_dynamic() const override { return true; }
             size_t encoded_size() const override {
                 return (_numbers.size() + 1) * ETH_WORD_SIZE;
             }
-            void encode_to(EncodeBuffer& buf, size_t) const override {
+            void encode_to(EncodeBuffer& buf) const override {
                 write_word(buf, _numbers.size());
-                for (auto i = _numbers.cbegin(); i != _numbers.cend(); ++i) {
-                    write_word(buf, *i);
-                }
+                encode_packed_to(buf);
+            }
+            // Packed arrays have no length prefix.
+            size_t packed_size() const override {
+                return _numbers.size() * ETH_WORD_SIZE;
+            }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                write_words(buf, _numbers.data(), _numbers.size());
             }
         };
 
@@ -288,21 +782,160 @@ namespace encoder {
         template <class TNumeric>
         class FixedNumericArrayValue: public DataValue {
         private:
-            vector<TNumeric> _numbers;
+            array_ref<const TNumeric> _numbers;
         public:
-            FixedNumericArrayValue(const vector<TNumeric>& numbers)
+            FixedNumericArrayValue(array_ref<const TNumeric> numbers)
                 : _numbers(numbers) {}
+            bool is_dynamic() const override { return false; }
             size_t encoded_size() const override {
                 return _numbers.size() * ETH_WORD_SIZE;
             }
-            void encode_to(EncodeBuffer& buf, size_t) const override {
-                for (auto i = _numbers.cbegin(); i != _numbers.cend(); ++i) {
-                    write_word(buf, *i);
-                }
+            void encode_to(EncodeBuffer& buf) const override {
+                write_words(buf, _numbers.data(), _numbers.size());
+            }
+        };
+
+        // Efficient version of FixedInlineArrayValue for `address` and
+        // `bytesN` elements, which are stored back to back and padded to
+        // words in bulk (see `kernels::pad_words()`).
+        class FixedPaddedArrayValue: public DataValue {
+        protected:
+            array_ref<const byte> _items;
+            size_t _item_size;
+            // Addresses are left-padded, bytesN right-padded.
+            bool _left_pad;
+
+        public:
+            FixedPaddedArrayValue(array_ref<const byte> items, size_t item_size, bool left_pad)
+                : _items(items), _item_size(item_size), _left_pad(left_pad) {
+                assert(item_size > 0 && item_size <= ETH_WORD_SIZE);
+                assert(_items.size() % item_size == 0);
+            }
+            size_t length() const { return _items.size() / _item_size; }
+            bool is_dynamic() const override { return false; }
+            size_t encoded_size() const override {
+                return length() * ETH_WORD_SIZE;
+            }
+            void encode_to(EncodeBuffer& buf) const override {
+                kernels::pad_words(
+                    buf.advance(length() * ETH_WORD_SIZE),
+                    _items.data(),
+                    length(),
+                    _item_size,
+                    _left_pad
+                );
+            }
+        };
+
+        class DynamicPaddedArrayValue: public FixedPaddedArrayValue {
+        public:
+            DynamicPaddedArrayValue(array_ref<const byte> items, size_t item_size, bool left_pad)
+                : FixedPaddedArrayValue(items, item_size, left_pad) {}
+            bool is_dynamic() const override { return true; }
+            size_t encoded_size() const override {
+                return FixedPaddedArrayValue::encoded_size() + ETH_WORD_SIZE;
+            }
+            void encode_to(EncodeBuffer& buf) const override {
+                write_word(buf, length());
+                FixedPaddedArrayValue::encode_to(buf);
+            }
+            // Packed arrays have no length prefix.
+            size_t packed_size() const override {
+                return FixedPaddedArrayValue::encoded_size();
+            }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                FixedPaddedArrayValue::encode_to(buf);
+            }
+        };
+
+        // A static tuple or array whose words were written when it was
+        // built, by a switch over its type rather than a node per element.
+        // Its leaves live in place in the words, and encoding is one copy
+        // with no calls per element.
+        class StaticWordsValue: public DataValue {
+        protected:
+            array_ref<const byte> _words;
+
+        public:
+            StaticWordsValue(array_ref<const byte> words): _words(words) {
+                assert(words.size() % ETH_WORD_SIZE == 0);
+            }
+            bool is_dynamic() const override { return false; }
+            size_t encoded_size() const override { return _words.size(); }
+            void encode_to(EncodeBuffer& buf) const override {
+                buf.write(_words.data(), _words.data() + _words.size());
+            }
+        };
+
+        // A dynamic array of static elements, written like
+        // `StaticWordsValue` and prefixed with its length.
+        class DynamicWordsArrayValue: public StaticWordsValue {
+        private:
+            size_t _length;
+
+        public:
+            DynamicWordsArrayValue(array_ref<const byte> words, size_t length)
+                : StaticWordsValue(words), _length(length) {}
+            bool is_dynamic() const override { return true; }
+            size_t encoded_size() const override {
+                return StaticWordsValue::encoded_size() + ETH_WORD_SIZE;
+            }
+            void encode_to(EncodeBuffer& buf) const override {
+                write_word(buf, _length);
+                StaticWordsValue::encode_to(buf);
+            }
+            // Packed arrays have no length prefix.
+            size_t packed_size() const override {
+                return StaticWordsValue::encoded_size();
+            }
+            void encode_packed_to(EncodeBuffer& buf) const override {
+                StaticWordsValue::encode_to(buf);
             }
         };
 
         typedef RefListValue RefStructValue;
         typedef InlineListValue InlineStructValue;
+        typedef MixedListValue MixedStructValue;
+    }
+
+    // Encodes a value into `out`, which must hold `v.encoded_size()` bytes.
+    // Large lists are split across up to `threads` threads.
+    inline void encode_value(
+        const values::DataValue& v,
+        byte* out,
+        size_t size,
+        unsigned threads = 1
+    ) {
+        EncodeBuffer buf(out, size, 0, threads);
+        v.encode_to(buf);
+        assert(buf.pos() == size);
+    }
+
+    inline buf_t encode_value(const values::DataValue& v) {
+        buf_t out(v.encoded_size());
+        encode_value(v, out.data(), out.size());
+        return out;
+    }
+
+    inline size_t packed_values_size(array_ref<values::DataValue* const> values) {
+        size_t size = 0;
+        for (auto v : values) {
+            size += v->packed_size();
+        }
+        return size;
+    }
+
+    // Concatenates the packed encoding of each value into `out`, which must
+    // hold `packed_values_size(values)` bytes.
+    inline void encode_packed_values(
+        array_ref<values::DataValue* const> values,
+        byte* out,
+        size_t size
+    ) {
+        EncodeBuffer buf(out, size);
+        for (auto v : values) {
+            v->encode_packed_to(buf);
+        }
+        assert(buf.pos() == size);
     }
 }
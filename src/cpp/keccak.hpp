@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace keccak {
+    using namespace std;
+
+    static const size_t KECCAK256_SIZE = 32;
+    // Bytes absorbed per permutation for a 256-bit capacity.
+    static const size_t KECCAK256_RATE = 136;
+
+    static const uint64_t ROUND_CONSTANTS[24] = {
+        0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL,
+        0x8000000080008000ULL, 0x000000000000808BULL, 0x0000000080000001ULL,
+        0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008AULL,
+        0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+        0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL,
+        0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+        0x000000000000800AULL, 0x800000008000000AULL, 0x8000000080008081ULL,
+        0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+    };
+
+    inline uint64_t rotl64(uint64_t x, unsigned n) {
+        return (x << n) | (x >> ((64 - n) & 63));
+    }
+
+    // Keccak-f[1600] over 25 lanes. Theta, rho+pi and chi are fully
+    // unrolled with the state held in locals so it stays in registers.
+    inline void permute(uint64_t st[25]) {
+        uint64_t a00 = st[0], a01 = st[1], a02 = st[2], a03 = st[3], a04 = st[4];
+        uint64_t a05 = st[5], a06 = st[6], a07 = st[7], a08 = st[8], a09 = st[9];
+        uint64_t a10 = st[10], a11 = st[11], a12 = st[12], a13 = st[13], a14 = st[14];
+        uint64_t a15 = st[15], a16 = st[16], a17 = st[17], a18 = st[18], a19 = st[19];
+        uint64_t a20 = st[20], a21 = st[21], a22 = st[22], a23 = st[23], a24 = st[24];
+        for (size_t round = 0; round < 24; ++round) {
+            // Theta.
+            uint64_t c0 = a00 ^ a05 ^ a10 ^ a15 ^ a20;
+            uint64_t c1 = a01 ^ a06 ^ a11 ^ a16 ^ a21;
+            uint64_t c2 = a02 ^ a07 ^ a12 ^ a17 ^ a22;
+            uint64_t c3 = a03 ^ a08 ^ a13 ^ a18 ^ a23;
+            uint64_t c4 = a04 ^ a09 ^ a14 ^ a19 ^ a24;
+            uint64_t d0 = c4 ^ rotl64(c1, 1);
+            uint64_t d1 = c0 ^ rotl64(c2, 1);
+            uint64_t d2 = c1 ^ rotl64(c3, 1);
+            uint64_t d3 = c2 ^ rotl64(c4, 1);
+            uint64_t d4 = c3 ^ rotl64(c0, 1);
+            // Rho and pi: b[y][2x+3y] = rot(a[x][y] ^ d[x]).
+            uint64_t b00 = a00 ^ d0;
+            uint64_t b01 = rotl64(a06 ^ d1, 44);
+            uint64_t b02 = rotl64(a12 ^ d2, 43);
+            uint64_t b03 = rotl64(a18 ^ d3, 21);
+            uint64_t b04 = rotl64(a24 ^ d4, 14);
+            uint64_t b05 = rotl64(a03 ^ d3, 28);
+            uint64_t b06 = rotl64(a09 ^ d4, 20);
+            uint64_t b07 = rotl64(a10 ^ d0, 3);
+            uint64_t b08 = rotl64(a16 ^ d1, 45);
+            uint64_t b09 = rotl64(a22 ^ d2, 61);
+            uint64_t b10 = rotl64(a01 ^ d1, 1);
+            uint64_t b11 = rotl64(a07 ^ d2, 6);
+            uint64_t b12 = rotl64(a13 ^ d3, 25);
+            uint64_t b13 = rotl64(a19 ^ d4, 8);
+            uint64_t b14 = rotl64(a20 ^ d0, 18);
+            uint64_t b15 = rotl64(a04 ^ d4, 27);
+            uint64_t b16 = rotl64(a05 ^ d0, 36);
+            uint64_t b17 = rotl64(a11 ^ d1, 10);
+            uint64_t b18 = rotl64(a17 ^ d2, 15);
+            uint64_t b19 = rotl64(a23 ^ d3, 56);
+            uint64_t b20 = rotl64(a02 ^ d2, 62);
+            uint64_t b21 = rotl64(a08 ^ d3, 55);
+            uint64_t b22 = rotl64(a14 ^ d4, 39);
+            uint64_t b23 = rotl64(a15 ^ d0, 41);
+            uint64_t b24 = rotl64(a21 ^ d1, 2);
+            // Chi and iota.
+            a00 = b00 ^ (~b01 & b02) ^ ROUND_CONSTANTS[round];
+            a01 = b01 ^ (~b02 & b03);
+            a02 = b02 ^ (~b03 & b04);
+            a03 = b03 ^ (~b04 & b00);
+            a04 = b04 ^ (~b00 & b01);
+            a05 = b05 ^ (~b06 & b07);
+            a06 = b06 ^ (~b07 & b08);
+            a07 = b07 ^ (~b08 & b09);
+            a08 = b08 ^ (~b09 & b05);
+            a09 = b09 ^ (~b05 & b06);
+            a10 = b10 ^ (~b11 & b12);
+            a11 = b11 ^ (~b12 & b13);
+            a12 = b12 ^ (~b13 & b14);
+            a13 = b13 ^ (~b14 & b10);
+            a14 = b14 ^ (~b10 & b11);
+            a15 = b15 ^ (~b16 & b17);
+            a16 = b16 ^ (~b17 & b18);
+            a17 = b17 ^ (~b18 & b19);
+            a18 = b18 ^ (~b19 & b15);
+            a19 = b19 ^ (~b15 & b16);
+            a20 = b20 ^ (~b21 & b22);
+            a21 = b21 ^ (~b22 & b23);
+            a22 = b22 ^ (~b23 & b24);
+            a23 = b23 ^ (~b24 & b20);
+            a24 = b24 ^ (~b20 & b21);
+        }
+        st[0] = a00; st[1] = a01; st[2] = a02; st[3] = a03; st[4] = a04;
+        st[5] = a05; st[6] = a06; st[7] = a07; st[8] = a08; st[9] = a09;
+        st[10] = a10; st[11] = a11; st[12] = a12; st[13] = a13; st[14] = a14;
+        st[15] = a15; st[16] = a16; st[17] = a17; st[18] = a18; st[19] = a19;
+        st[20] = a20; st[21] = a21; st[22] = a22; st[23] = a23; st[24] = a24;
+    }
+
+    inline uint64_t load_le64(const byte* p) {
+        uint64_t n;
+        memcpy(&n, p, sizeof(n));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        n = __builtin_bswap64(n);
+#endif
+        return n;
+    }
+
+    inline void store_le64(byte* p, uint64_t n) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        n = __builtin_bswap64(n);
+#endif
+        memcpy(p, &n, sizeof(n));
+    }
+
+    // Sponge with a 256-bit output. `domain` is the padding byte, which is
+    // what distinguishes the original Keccak (0x01) from SHA3 (0x06).
+    inline void sponge256(const byte* data, size_t size, byte* out, byte domain) {
+        uint64_t st[25] = { 0 };
+        while (size >= KECCAK256_RATE) {
+            for (size_t i = 0; i < KECCAK256_RATE / 8; ++i) {
+                st[i] ^= load_le64(data + i * 8);
+            }
+            permute(st);
+            data += KECCAK256_RATE;
+            size -= KECCAK256_RATE;
+        }
+        byte block[KECCAK256_RATE] = {};
+        memcpy(block, data, size);
+        block[size] ^= domain;
+        block[KECCAK256_RATE - 1] ^= byte(0x80);
+        for (size_t i = 0; i < KECCAK256_RATE / 8; ++i) {
+            st[i] ^= load_le64(block + i * 8);
+        }
+        permute(st);
+        for (size_t i = 0; i < KECCAK256_SIZE / 8; ++i) {
+            store_le64(out + i * 8, st[i]);
+        }
+    }
+
+    // The Keccak-256 used by Ethereum (not NIST SHA3-256).
+    inline void keccak256(const byte* data, size_t size, byte* out) {
+        sponge256(data, size, out, byte(0x01));
+    }
+}
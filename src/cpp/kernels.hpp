@@ -0,0 +1,180 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+// AVX2 kernels are compiled with a target attribute and picked at runtime,
+// so the build doesn't need -mavx2.
+#define ENCODER_KERNELS_AVX2 1
+#endif
+
+// Bulk word emission for arrays of fixed-size items.
+namespace encoder {
+    namespace kernels {
+        using namespace std;
+
+        // Widens `n` native unsigned integers into consecutive zero-padded,
+        // big-endian 32-byte words, one at a time.
+        template <class TUint>
+        void widen_uint_words_generic(byte* out, const TUint* in, size_t n) {
+            for (size_t i = 0; i < n; ++i, out += 32) {
+                auto be = uint64_t(in[i]);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                be = __builtin_bswap64(be);
+#endif
+                memset(out, 0, 24);
+                memcpy(out + 24, &be, 8);
+            }
+        }
+
+#ifdef ENCODER_KERNELS_AVX2
+        // Four integers at a time: one load zero-extends them to 64-bit
+        // lanes, one shuffle byte-swaps all four, and each word is then
+        // a single 32-byte store of its lane moved to the top of an
+        // otherwise zero vector.
+        template <class TUint>
+        __attribute__((target("avx2")))
+        void widen_uint_words_avx2(byte* out, const TUint* in, size_t n) {
+            const __m256i bswap64 = _mm256_setr_epi8(
+                7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+            );
+            const __m256i zero = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4, out += 128) {
+                __m256i v;
+                if constexpr (sizeof(TUint) == 1) {
+                    int32_t packed;
+                    memcpy(&packed, in + i, 4);
+                    v = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+                } else if constexpr (sizeof(TUint) == 2) {
+                    v = _mm256_cvtepu16_epi64(_mm_loadl_epi64((const __m128i*) (in + i)));
+                } else if constexpr (sizeof(TUint) == 4) {
+                    v = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*) (in + i)));
+                } else {
+                    v = _mm256_loadu_si256((const __m256i*) (in + i));
+                }
+                v = _mm256_shuffle_epi8(v, bswap64);
+                // Lane k to the top 8 bytes of word k.
+                _mm256_storeu_si256((__m256i*) out, _mm256_blend_epi32(zero, _mm256_permute4x64_epi64(v, 0x00), 0xC0));
+                _mm256_storeu_si256((__m256i*) (out + 32), _mm256_blend_epi32(zero, _mm256_permute4x64_epi64(v, 0x55), 0xC0));
+                _mm256_storeu_si256((__m256i*) (out + 64), _mm256_blend_epi32(zero, _mm256_permute4x64_epi64(v, 0xAA), 0xC0));
+                _mm256_storeu_si256((__m256i*) (out + 96), _mm256_blend_epi32(zero, v, 0xC0));
+            }
+            widen_uint_words_generic(out, in + i, n - i);
+        }
+#endif
+
+        // Above this many words the output no longer fits in L1, and the
+        // kernels are bound by cache bandwidth instead, where the generic
+        // one's narrower stores split fewer cache lines (see `bench.cc`).
+        static const size_t WIDEN_VECTOR_MAX_WORDS = 1024;
+
+        // Picks the best kernel for the CPU once per integer type, as
+        // `pad_words()` does.
+        template <class TUint>
+        void widen_uint_words(byte* out, const TUint* in, size_t n) {
+            static_assert(is_unsigned<TUint>::value && sizeof(TUint) <= 8, "expected a native unsigned type");
+            typedef void (*kernel_t)(byte*, const TUint*, size_t);
+            static const kernel_t kernel = [] {
+#ifdef ENCODER_KERNELS_AVX2
+                if (__builtin_cpu_supports("avx2")) {
+                    return kernel_t(&widen_uint_words_avx2<TUint>);
+                }
+#endif
+                return kernel_t(&widen_uint_words_generic<TUint>);
+            }();
+            if (n > WIDEN_VECTOR_MAX_WORDS) {
+                return widen_uint_words_generic(out, in, n);
+            }
+            kernel(out, in, n);
+        }
+
+        typedef void (*pad_words_t)(byte* out, const byte* in, size_t n);
+
+        // Emits `n` words from `TSize`-byte items stored back to back at
+        // `in`, left-padded with zeroes (addresses) or right-padded (bytesN).
+        // Every word is zeroed with full stores and then the item copied
+        // over it with a constant-size memcpy, which compiles to a few
+        // unaligned vector moves.
+        template <size_t TSize, bool TLeftPad>
+        void pad_words_generic(byte* out, const byte* in, size_t n) {
+            for (size_t i = 0; i < n; ++i, out += 32, in += TSize) {
+#if defined(__SSE2__)
+                _mm_storeu_si128((__m128i*) out, _mm_setzero_si128());
+                _mm_storeu_si128((__m128i*) (out + 16), _mm_setzero_si128());
+#else
+                memset(out, 0, 32);
+#endif
+                memcpy(out + (TLeftPad ? 32 - TSize : 0), in, TSize);
+            }
+        }
+
+#ifdef ENCODER_KERNELS_AVX2
+        // One masked load and one store per word. Masked-off lanes are
+        // never read, so left-padded items can be loaded from before their
+        // start without faulting.
+        template <size_t TSize, bool TLeftPad>
+        __attribute__((target("avx2")))
+        void pad_words_avx2(byte* out, const byte* in, size_t n) {
+            static_assert(TSize % 4 == 0, "AVX2 kernel needs whole 32-bit lanes");
+            const size_t lanes = TSize / 4;
+            const __m256i lane_ids = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m256i mask = TLeftPad
+                ? _mm256_cmpgt_epi32(lane_ids, _mm256_set1_epi32(int(7 - lanes)))
+                : _mm256_cmpgt_epi32(_mm256_set1_epi32(int(lanes)), lane_ids);
+            auto src = uintptr_t(in) - (TLeftPad ? 32 - TSize : 0);
+            for (size_t i = 0; i < n; ++i, out += 32, src += TSize) {
+                __m256i word = TSize == 32
+                    ? _mm256_loadu_si256((const __m256i*) src)
+                    : _mm256_maskload_epi32((const int*) src, mask);
+                _mm256_storeu_si256((__m256i*) out, word);
+            }
+        }
+#endif
+
+        template <size_t TSize, bool TLeftPad>
+        pad_words_t select_pad_words() {
+#ifdef ENCODER_KERNELS_AVX2
+            if constexpr (TSize % 4 == 0) {
+                if (__builtin_cpu_supports("avx2")) {
+                    return &pad_words_avx2<TSize, TLeftPad>;
+                }
+            }
+#endif
+            return &pad_words_generic<TSize, TLeftPad>;
+        }
+
+        // Picks the best kernel for the CPU once per item layout.
+        template <size_t TSize, bool TLeftPad>
+        void pad_words(byte* out, const byte* in, size_t n) {
+            static const pad_words_t kernel = select_pad_words<TSize, TLeftPad>();
+            kernel(out, in, n);
+        }
+
+        template <size_t... TSizes>
+        void pad_words(
+            byte* out,
+            const byte* in,
+            size_t n,
+            size_t item_size,
+            bool left_pad,
+            index_sequence<TSizes...>
+        ) {
+            static const pad_words_t left[] = { &pad_words<TSizes + 1, true>... };
+            static const pad_words_t right[] = { &pad_words<TSizes + 1, false>... };
+            (left_pad ? left : right)[item_size - 1](out, in, n);
+        }
+
+        // Runtime item size (1 to 32 bytes) version of the above.
+        inline void pad_words(byte* out, const byte* in, size_t n, size_t item_size, bool left_pad) {
+            pad_words(out, in, n, item_size, left_pad, make_index_sequence<32>());
+        }
+    }
+}
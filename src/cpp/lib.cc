@@ -1,19 +1,1960 @@
 #include <napi.h>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
 #include "num.hpp"
 #include "encoders.hpp"
+#include "plan.hpp"
+#include "decoders.hpp"
+#include "typed.hpp"
+#include "keccak.hpp"
 
 using namespace std;
+using namespace encoder;
+using namespace encoder::values;
 
+typedef Napi::External<plan::PlanPtr> PlanHandle;
 
-Napi::Value foo(const Napi::CallbackInfo& info) {
-    auto typeData = info[0].As<Napi::Object>();
-    return typeData.Get("name");
+// Compiles a JS ABI type, e.g., `{ type: 'tuple[]', components: [...] }`
+// or just `'uint256'`, into the plan.
+size_t compile_type(plan::Plan& p, const Napi::Value& v) {
+    if (v.IsString()) {
+        return p.add_type(v.As<Napi::String>().Utf8Value());
+    }
+    if (!v.IsObject()) {
+        throw invalid_argument("expected an ABI type descriptor");
+    }
+    auto obj = v.As<Napi::Object>();
+    auto type = obj.Get("type");
+    if (!type.IsString()) {
+        throw invalid_argument("ABI type descriptor has no type");
+    }
+    vector<plan::Field> components;
+    auto components_value = obj.Get("components");
+    if (components_value.IsArray()) {
+        auto arr = components_value.As<Napi::Array>();
+        for (uint32_t i = 0; i < arr.Length(); ++i) {
+            auto component = arr.Get(i);
+            string name;
+            if (component.IsObject()) {
+                auto n = component.As<Napi::Object>().Get("name");
+                if (n.IsString()) {
+                    name = n.As<Napi::String>().Utf8Value();
+                }
+            }
+            components.push_back({ compile_type(p, component), 0, name });
+        }
+    }
+    return p.add_type(type.As<Napi::String>().Utf8Value(), components);
 }
 
+// Compiles an array of JS ABI types into a plan for their tuple.
+shared_ptr<plan::Plan> compile_types(const Napi::Array& types) {
+    auto p = make_shared<plan::Plan>();
+    vector<plan::Field> fields;
+    for (uint32_t i = 0; i < types.Length(); ++i) {
+        fields.push_back({ compile_type(*p, types.Get(i)), 0, "" });
+    }
+    p->set_root(p->add_tuple(fields));
+    return p;
+}
+
+// Reads a signature like `transfer(address,uint256)` from a string or
+// builds it from an ABI fragment (`{ name, inputs }`).
+string to_signature(const Napi::Value& v) {
+    if (v.IsString()) {
+        return v.As<Napi::String>().Utf8Value();
+    }
+    if (v.IsObject()) {
+        auto obj = v.As<Napi::Object>();
+        auto name = obj.Get("name");
+        auto inputs = obj.Get("inputs");
+        if (name.IsString() && inputs.IsArray()) {
+            return name.As<Napi::String>().Utf8Value()
+                + compile_types(inputs.As<Napi::Array>())->signature();
+        }
+    }
+    throw invalid_argument("expected a signature or an ABI fragment");
+}
+
+// Compiles an array of types, or the inputs of an ABI function fragment.
+// Functions get their selector prepended when encoding.
+plan::PlanPtr compile_plan(const Napi::Value& v) {
+    if (v.IsArray()) {
+        return compile_types(v.As<Napi::Array>());
+    }
+    if (v.IsObject()) {
+        auto obj = v.As<Napi::Object>();
+        auto inputs = obj.Get("inputs");
+        if (inputs.IsArray()) {
+            auto p = compile_types(inputs.As<Napi::Array>());
+            auto name = obj.Get("name");
+            if (name.IsString()) {
+                auto sig = name.As<Napi::String>().Utf8Value() + p->signature();
+                byte hash[keccak::KECCAK256_SIZE];
+                keccak::keccak256((const byte*) sig.data(), sig.size(), hash);
+                p->set_selector(hash);
+            }
+            return p;
+        }
+    }
+    throw invalid_argument("expected an array of types or an ABI fragment");
+}
+
+// Plans for arrays of type strings, e.g. `['address', 'uint256']`, keyed
+// by the types, so passing them to `encode()` or `decode()` over and over
+// doesn't recompile them each time. Descriptor objects aren't cached, as
+// keying them would take walking them about as far as compiling them. One
+// cache per thread, which is one per JS environment, and cleared when full
+// rather than tracking use.
+plan::PlanPtr compile_cached(const Napi::Array& types) {
+    static const size_t MAX_CACHED_PLANS = 256;
+    thread_local unordered_map<string, plan::PlanPtr> cache;
+    string key;
+    for (uint32_t i = 0; i < types.Length(); ++i) {
+        auto type = types.Get(i);
+        if (!type.IsString()) {
+            return compile_types(types);
+        }
+        // Length-prefixed, so no two arrays share a key.
+        auto s = type.As<Napi::String>().Utf8Value();
+        key += to_string(s.size()) + ":" + s;
+    }
+    auto cached = cache.find(key);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+    plan::PlanPtr p = compile_types(types);
+    if (cache.size() >= MAX_CACHED_PLANS) {
+        cache.clear();
+    }
+    cache.emplace(move(key), p);
+    return p;
+}
+
+// Accepts either a handle returned by `compile()`, an array of types, or an
+// ABI function fragment.
+plan::PlanPtr to_plan(const Napi::Value& v) {
+    if (v.IsExternal()) {
+        return *v.As<PlanHandle>().Data();
+    }
+    if (v.IsArray()) {
+        return compile_cached(v.As<Napi::Array>());
+    }
+    return compile_plan(v);
+}
+
+Napi::String to_hex_string(Napi::Env env, const byte* data, size_t size) {
+    static const char* digits = "0123456789abcdef";
+    string s(2 + size * 2, '0');
+    s[1] = 'x';
+    for (size_t i = 0; i < size; ++i) {
+        s[2 + i * 2] = digits[unsigned(data[i]) >> 4];
+        s[3 + i * 2] = digits[unsigned(data[i]) & 0xF];
+    }
+    return Napi::String::New(env, s);
+}
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Checks a hex string, with or without a 0x prefix, and returns where its
+// digits start.
+size_t hex_start(const string& s) {
+    size_t start = 0;
+    if (s.size() >= 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        start = 2;
+    }
+    if ((s.size() - start) % 2) {
+        throw invalid_argument("hex string has an odd length");
+    }
+    return start;
+}
+
+// Decodes the hex digits of `s` from `start` into `out`.
+void decode_hex(const string& s, size_t start, byte* out) {
+    for (size_t i = 0; i < (s.size() - start) / 2; ++i) {
+        auto hi = hex_digit(s[start + i * 2]);
+        auto lo = hex_digit(s[start + i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            throw invalid_argument("invalid hex string");
+        }
+        out[i] = byte((hi << 4) | lo);
+    }
+}
+
+bool is_uint8_array(const Napi::Value& v) {
+    return v.IsTypedArray()
+        && v.As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array;
+}
+
+// Reads a byte string from a Buffer/Uint8Array or a hex string. Buffers
+// are referenced in place when the store can borrow, so their bytes are
+// only copied once, into the output; otherwise they are copied into the
+// store's arena, as are decoded hex strings.
+array_ref<const byte> to_bytes(ValueStore& store, const Napi::Value& v) {
+    if (v.IsTypedArray()) {
+        if (!is_uint8_array(v)) {
+            throw invalid_argument("expected a Uint8Array");
+        }
+        auto arr = v.As<Napi::Uint8Array>();
+        auto data = (const byte*) arr.Data();
+        if (store.can_borrow()) {
+            return array_ref<const byte>(data, arr.ByteLength());
+        }
+        return store.copy_array(data, arr.ByteLength());
+    }
+    if (!v.IsString()) {
+        throw invalid_argument("expected a Buffer or hex string");
+    }
+    auto s = v.As<Napi::String>().Utf8Value();
+    auto start = hex_start(s);
+    auto r = store.make_array<byte>((s.size() - start) / 2);
+    decode_hex(s, start, r.data());
+    return r;
+}
+
+// Reads exactly `expected_size` bytes of an address or bytesN into `out`,
+// without an intermediate copy.
+void to_fixed_bytes(const Napi::Value& v, size_t expected_size, const string& signature, byte* out) {
+    size_t size;
+    string s;
+    size_t start = 0;
+    if (is_uint8_array(v)) {
+        size = v.As<Napi::Uint8Array>().ByteLength();
+    } else if (v.IsString()) {
+        s = v.As<Napi::String>().Utf8Value();
+        start = hex_start(s);
+        size = (s.size() - start) / 2;
+    } else if (v.IsTypedArray()) {
+        throw invalid_argument("expected a Uint8Array");
+    } else {
+        throw invalid_argument("expected a Buffer or hex string");
+    }
+    if (size != expected_size) {
+        if (signature == "address") {
+            throw invalid_argument("address must be 20 bytes");
+        }
+        throw invalid_argument("wrong number of bytes for " + signature);
+    }
+    if (is_uint8_array(v)) {
+        memcpy(out, v.As<Napi::Uint8Array>().Data(), size);
+    } else {
+        decode_hex(s, start, out);
+    }
+}
+
+void to_fixed_bytes(const Napi::Value& v, const plan::Node& type, byte* out) {
+    to_fixed_bytes(v, type.size, type.signature, out);
+}
+
+// Byte length of a JS string's UTF-8, without converting it.
+size_t utf8_size(const Napi::Value& v) {
+    size_t size;
+    if (!v.IsString() || napi_get_value_string_utf8(v.Env(), v, nullptr, 0, &size) != napi_ok) {
+        throw invalid_argument("expected a string");
+    }
+    return size;
+}
+
+// A `string` whose UTF-8 is written by N-API straight from the JS string
+// into the output, only when encoded. Only for stores that can defer.
+// N-API always writes a NUL after the string, which lands in the padding,
+// so `build_string()` copies strings that end on a word boundary instead.
+class JsStringValue: public DataValue {
+private:
+    napi_env _env;
+    napi_value _value;
+    size_t _size;
+
+    // Writes the UTF-8 and zeroes up to `padded_size` bytes.
+    void write_utf8(EncodeBuffer& buf, size_t padded_size) const {
+        assert(padded_size > _size);
+        auto out = buf.advance(padded_size);
+        size_t copied = 0;
+        napi_get_value_string_utf8(_env, _value, (char*) out, _size + 1, &copied);
+        memset(out + copied, 0, padded_size - copied);
+    }
+
+public:
+    JsStringValue(napi_env env, napi_value value, size_t size)
+        : _env(env), _value(value), _size(size) {}
+    bool is_dynamic() const override { return true; }
+    size_t encoded_size() const override {
+        return ETH_WORD_SIZE + align_size(_size);
+    }
+    void encode_to(EncodeBuffer& buf) const override {
+        write_word(buf, _size);
+        write_utf8(buf, align_size(_size));
+    }
+    // Packed strings have no padding to hold the NUL, so this goes through
+    // a copy; `encodePacked()` builds `StringValue`s instead.
+    size_t packed_size() const override { return _size; }
+    void encode_packed_to(EncodeBuffer& buf) const override {
+        auto s = Napi::String(_env, _value).Utf8Value();
+        buf.write((const byte*) s.data(), (const byte*) s.data() + s.size());
+    }
+};
+
+// Strings are read straight into the output when the store can defer, and
+// otherwise converted once into the store's arena.
+DataValue* build_string(ValueStore& store, const Napi::Value& value) {
+    auto size = utf8_size(value);
+    if (store.can_defer() && size % ETH_WORD_SIZE) {
+        return store.make<JsStringValue>(value.Env(), value, size);
+    }
+    // With room for the NUL.
+    auto utf8 = store.make_array<byte>(size + 1);
+    napi_get_value_string_utf8(value.Env(), value, (char*) utf8.data(), size + 1, &size);
+    return store.make<StringValue>(array_ref<const byte>(utf8.data(), size));
+}
+
+// Largest integer a double holds exactly (`Number.MAX_SAFE_INTEGER`).
+static const double MAX_SAFE_INTEGER = 9007199254740991.0;
+
+// Whether a BigInt is below zero. N-API only gives the sign along with the
+// words, so this copies them; it's for error paths.
+bool bigint_is_negative(Napi::BigInt big) {
+    size_t count = big.WordCount();
+    // N-API wants a buffer even for no words.
+    vector<uint64_t> words(max<size_t>(count, 1));
+    int sign_bit = 0;
+    big.ToWords(&sign_bit, &count, words.data());
+    return sign_bit != 0;
+}
+
+// A BigInt that doesn't fit: negative values for unsigned types are
+// reported as such whatever their size, as for Numbers and strings.
+[[noreturn]] void throw_bigint_out_of_range(Napi::BigInt big, bool is_signed) {
+    if (!is_signed && bigint_is_negative(big)) {
+        throw invalid_argument("negative value for unsigned type");
+    }
+    throw invalid_argument("integer out of range");
+}
+
+// Reads a 256-bit integer from a BigInt's words.
+template <bool TSigned>
+num::wide_int<TSigned> bigint_to_wide(Napi::BigInt big) {
+    uint64_t words[4];
+    size_t count = big.WordCount();
+    if (count > 4) {
+        throw_bigint_out_of_range(big, TSigned);
+    }
+    int sign_bit = 0;
+    big.ToWords(&sign_bit, &count, words);
+    auto magnitude = from_limbs<num::wide_int<TSigned>>(words, count);
+    bool is_negative = sign_bit && magnitude != 0;
+    if (is_negative && !TSigned) {
+        throw invalid_argument("negative value for unsigned type");
+    }
+    auto n = is_negative ? -magnitude : magnitude;
+    // Two's complement wraps magnitudes that don't fit.
+    if (n.is_negative() != is_negative) {
+        throw invalid_argument("integer out of range");
+    }
+    return n;
+}
+
+// Reads an integer from a Number, BigInt, or numeric string into the
+// storage for a `uintN`/`intN` (`num::int_t`), checking only that it fits
+// the storage; `IntValue` checks the N-bit range. Safe integer Numbers and
+// BigInts of up to 64 bits convert natively, wider BigInts are copied word
+// by word into the limbs, and only strings go through parsing.
+template <unsigned TBits, bool TSigned>
+num::int_t<TBits, TSigned> to_int(const Napi::Value& v) {
+    typedef num::int_t<TBits, TSigned> int_type;
+    const unsigned storage_bits = sizeof(int_type) * 8;
+    num::wide_int<TSigned> wide;
+    if (v.IsNumber()) {
+        auto d = v.As<Napi::Number>().DoubleValue();
+        if (!(d >= -MAX_SAFE_INTEGER && d <= MAX_SAFE_INTEGER) || d != double(int64_t(d))) {
+            throw invalid_argument("number is not a safe integer; use a bigint or string");
+        }
+        auto n = int64_t(d);
+        if (n < 0 && !TSigned) {
+            throw invalid_argument("negative value for unsigned type");
+        }
+        if constexpr (storage_bits < 64) {
+            if (int64_t(int_type(n)) != n) {
+                throw invalid_argument("integer out of range");
+            }
+        }
+        return int_type(n);
+    }
+    if (v.IsBigInt()) {
+        auto big = v.As<Napi::BigInt>();
+        if constexpr (storage_bits <= 64) {
+            bool lossless;
+            if constexpr (TSigned) {
+                auto n = big.Int64Value(&lossless);
+                if (lossless && int64_t(int_type(n)) == n) {
+                    return int_type(n);
+                }
+            } else {
+                auto n = big.Uint64Value(&lossless);
+                if (lossless && uint64_t(int_type(n)) == n) {
+                    return int_type(n);
+                }
+            }
+            throw_bigint_out_of_range(big, TSigned);
+        }
+        wide = bigint_to_wide<TSigned>(big);
+    } else if (v.IsString()) {
+        auto s = v.As<Napi::String>().Utf8Value();
+        if (!TSigned && !s.empty() && s[0] == '-') {
+            throw invalid_argument("negative value for unsigned type");
+        }
+        try {
+            wide = num::wide_int<TSigned>(s);
+        } catch (const exception&) {
+            throw invalid_argument("invalid integer: " + s);
+        }
+    } else {
+        throw invalid_argument("expected a number, bigint, or numeric string");
+    }
+    if (!wide.fits_bits(storage_bits)) {
+        throw invalid_argument("integer out of range");
+    }
+    return num::narrow<int_type>(wide);
+}
+
+DataValue* build_value(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value
+);
+
+Napi::Array to_array(const Napi::Value& value, const plan::Node& type) {
+    if (!value.IsArray()) {
+        throw invalid_argument("expected an array for " + type.signature);
+    }
+    auto arr = value.As<Napi::Array>();
+    bool is_fixed = type.op == plan::Op::FixedUintArray
+        || type.op == plan::Op::FixedInlineArray
+        || type.op == plan::Op::FixedRefArray;
+    if (is_fixed && arr.Length() != type.length) {
+        throw invalid_argument("wrong array length for " + type.signature);
+    }
+    return arr;
+}
+
+array_ref<DataValue* const> build_elements(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value
+) {
+    auto arr = to_array(value, type);
+    const auto& element_type = p.node(type.element);
+    auto elements = store.make_array<DataValue*>(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+        elements[i] = build_value(store, p, element_type, arr.Get(i));
+    }
+    return elements;
+}
+
+// Tuples can be given by position (an array) or by component name (an
+// object).
+Napi::Object to_tuple(const Napi::Value& value, const plan::Node& type, bool& is_array) {
+    if (!value.IsObject()) {
+        throw invalid_argument("expected an array or object for " + type.signature);
+    }
+    is_array = value.IsArray();
+    if (is_array && value.As<Napi::Array>().Length() != type.field_count) {
+        throw invalid_argument("wrong number of values for " + type.signature);
+    }
+    return value.As<Napi::Object>();
+}
+
+Napi::Value get_field(const Napi::Object& tuple, bool is_array, const plan::Field& field, size_t i) {
+    return is_array ? tuple.Get(uint32_t(i)) : tuple.Get(field.name);
+}
+
+array_ref<DataValue* const> build_fields(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value
+) {
+    bool is_array;
+    auto tuple = to_tuple(value, type, is_array);
+    auto elements = store.make_array<DataValue*>(type.field_count);
+    for (size_t i = 0; i < type.field_count; ++i) {
+        const auto& field = p.field(type, i);
+        elements[i] = build_value(store, p, p.node(field.node), get_field(tuple, is_array, field, i));
+    }
+    return elements;
+}
+
+bool is_padded_element(const plan::Node& element) {
+    return element.op == plan::Op::Address || element.op == plan::Op::FixedBytes;
+}
+
+// address[] and bytesN[]: elements are gathered back to back and padded to
+// words in bulk.
+DataValue* build_padded_array(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value
+) {
+    const auto& element = p.node(type.element);
+    auto arr = to_array(value, type);
+    auto items = store.make_array<byte>(arr.Length() * element.size);
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+        to_fixed_bytes(arr.Get(i), element, items.data() + i * element.size);
+    }
+    bool left_pad = element.op == plan::Op::Address;
+    if (type.op == plan::Op::FixedInlineArray) {
+        return store.make<FixedPaddedArrayValue>(items, element.size, left_pad);
+    }
+    return store.make<DynamicPaddedArrayValue>(items, element.size, left_pad);
+}
+
+typedef DataValue* (*int_builder_t)(ValueStore&, const plan::Node&, const Napi::Value&);
+
+template <unsigned TBits, bool TSigned>
+DataValue* build_int(ValueStore& store, const plan::Node&, const Napi::Value& value) {
+    return store.make<IntValue<TBits, TSigned>>(to_int<TBits, TSigned>(value));
+}
+
+// Encodes a typed array's elements in place when the store can borrow,
+// else from a copy.
+template <unsigned TBits, class TElement>
+DataValue* build_uint_span(
+    ValueStore& store,
+    const plan::Node& type,
+    const Napi::TypedArrayOf<TElement>& arr
+) {
+    const TElement* data = arr.Data();
+    size_t size = arr.ElementLength();
+    bool is_fixed = type.op == plan::Op::FixedUintArray;
+    if (is_fixed && size != type.length) {
+        throw invalid_argument("wrong array length for " + type.signature);
+    }
+    if constexpr (TBits < sizeof(TElement) * 8) {
+        for (size_t i = 0; i < size; ++i) {
+            if (!num::fits_bits<TBits>(data[i])) {
+                throw invalid_argument("value out of range for " + type.signature);
+            }
+        }
+    }
+    auto numbers = store.can_borrow()
+        ? array_ref<const TElement>(data, size)
+        : store.copy_array(data, size);
+    if (is_fixed) {
+        return store.make<FixedNumericArrayValue<TElement>>(numbers);
+    }
+    return store.make<DynamicNumericArrayValue<TElement>>(numbers);
+}
+
+// Elements are stored natively and written straight from the arena.
+// Unsigned typed arrays (Uint8Array, Uint16Array, Uint32Array and
+// BigUint64Array) are taken as-is, without boxing each element.
+template <unsigned TBits>
+DataValue* build_uint_array(
+    ValueStore& store,
+    const plan::Node& type,
+    const Napi::Value& value
+) {
+    if (value.IsTypedArray()) {
+        auto typed = value.As<Napi::TypedArray>();
+        switch (typed.TypedArrayType()) {
+            case napi_uint8_array:
+                return build_uint_span<TBits>(store, type, value.As<Napi::Uint8Array>());
+            case napi_uint16_array:
+                return build_uint_span<TBits>(store, type, value.As<Napi::Uint16Array>());
+            case napi_uint32_array:
+                return build_uint_span<TBits>(store, type, value.As<Napi::Uint32Array>());
+            case napi_biguint64_array:
+                return build_uint_span<TBits>(store, type, value.As<Napi::BigUint64Array>());
+            default:
+                throw invalid_argument("unsupported typed array for " + type.signature);
+        }
+    }
+    typedef IntValue<TBits, false> element_t;
+    auto arr = to_array(value, type);
+    auto numbers = store.make_array<typename element_t::value_type>(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+        numbers[i] = element_t::check(to_int<TBits, false>(arr.Get(i)));
+    }
+    if (type.op == plan::Op::FixedUintArray) {
+        return store.make<FixedNumericArrayValue<typename element_t::value_type>>(numbers);
+    }
+    return store.make<DynamicNumericArrayValue<typename element_t::value_type>>(numbers);
+}
+
+template <size_t... TBytes>
+int_builder_t int_builder(plan::Op op, unsigned bits, index_sequence<TBytes...>) {
+    static const int_builder_t uints[] = { &build_int<(TBytes + 1) * 8, false>... };
+    static const int_builder_t ints[] = { &build_int<(TBytes + 1) * 8, true>... };
+    static const int_builder_t uint_arrays[] = { &build_uint_array<(TBytes + 1) * 8>... };
+    auto i = bits / 8 - 1;
+    return op == plan::Op::Uint ? uints[i]
+        : op == plan::Op::Int ? ints[i]
+        : uint_arrays[i];
+}
+
+// The builder specialized for an integer (or integer array element) width.
+int_builder_t int_builder(plan::Op op, unsigned bits) {
+    return int_builder(op, bits, make_index_sequence<ETH_WORD_SIZE>());
+}
+
+typedef void (*int_writer_t)(EncodeBuffer&, const Napi::Value&);
+
+template <unsigned TBits, bool TSigned>
+void write_int(EncodeBuffer& buf, const Napi::Value& value) {
+    write_word(buf, IntValue<TBits, TSigned>::check(to_int<TBits, TSigned>(value)));
+}
+
+template <size_t... TBytes>
+int_writer_t int_writer(bool is_signed, unsigned bits, index_sequence<TBytes...>) {
+    static const int_writer_t uints[] = { &write_int<(TBytes + 1) * 8, false>... };
+    static const int_writer_t ints[] = { &write_int<(TBytes + 1) * 8, true>... };
+    return (is_signed ? ints : uints)[bits / 8 - 1];
+}
+
+// Writes the words of a static value straight from JS, switching on its
+// type, so a static tuple or array needs no node per element. Only unsigned
+// integer arrays go through their own value, to keep the typed array path.
+void write_static(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value,
+    EncodeBuffer& buf
+) {
+    switch (type.op) {
+        case plan::Op::Uint:
+        case plan::Op::Int:
+            return int_writer(
+                type.op == plan::Op::Int,
+                type.size,
+                make_index_sequence<ETH_WORD_SIZE>()
+            )(buf, value);
+        case plan::Op::Bool:
+            return write_word(buf, uint8_t(value.ToBoolean() ? 1 : 0));
+        case plan::Op::Address: {
+            auto word = buf.advance(ETH_WORD_SIZE);
+            memset(word, 0, ETH_WORD_SIZE - type.size);
+            return to_fixed_bytes(value, type, word + ETH_WORD_SIZE - type.size);
+        }
+        case plan::Op::FixedBytes: {
+            auto word = buf.advance(ETH_WORD_SIZE);
+            to_fixed_bytes(value, type, word);
+            memset(word + type.size, 0, ETH_WORD_SIZE - type.size);
+            return;
+        }
+        case plan::Op::InlineTuple: {
+            bool is_array;
+            auto tuple = to_tuple(value, type, is_array);
+            for (size_t i = 0; i < type.field_count; ++i) {
+                const auto& field = p.field(type, i);
+                write_static(store, p, p.node(field.node), get_field(tuple, is_array, field, i), buf);
+            }
+            return;
+        }
+        case plan::Op::FixedInlineArray: {
+            auto arr = to_array(value, type);
+            const auto& element = p.node(type.element);
+            for (uint32_t i = 0; i < type.length; ++i) {
+                write_static(store, p, element, arr.Get(i), buf);
+            }
+            return;
+        }
+        case plan::Op::FixedUintArray:
+            return int_builder(type.op, p.node(type.element).size)(store, type, value)
+                ->encode_to(buf);
+        default:
+            throw logic_error("not a static type: " + type.signature);
+    }
+}
+
+// Static tuples and arrays, e.g. the elements of `(uint256,address)[]`,
+// are written into their words as they are built.
+DataValue* build_static(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value
+) {
+    auto words = store.make_array<byte>(type.head_size);
+    // Sized by plan arithmetic rather than the value, so checked.
+    auto buf = EncodeBuffer::checked(words.data(), words.size());
+    write_static(store, p, type, value, buf);
+    return store.make<StaticWordsValue>(words);
+}
+
+DataValue* build_static_array(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value
+) {
+    auto arr = to_array(value, type);
+    const auto& element = p.node(type.element);
+    size_t length = arr.Length();
+    auto words = store.make_array<byte>(plan::checked_size_mul(length, element.head_size));
+    auto buf = EncodeBuffer::checked(words.data(), words.size());
+    for (uint32_t i = 0; i < length; ++i) {
+        write_static(store, p, element, arr.Get(i), buf);
+    }
+    return store.make<DynamicWordsArrayValue>(words, length);
+}
+
+DataValue* build_value(
+    ValueStore& store,
+    const plan::Plan& p,
+    const plan::Node& type,
+    const Napi::Value& value
+) {
+    switch (type.op) {
+        case plan::Op::Uint:
+        case plan::Op::Int:
+            return int_builder(type.op, type.size)(store, type, value);
+        case plan::Op::Bool:
+            return store.make<IntValue<8, false>>(uint8_t(value.ToBoolean() ? 1 : 0));
+        case plan::Op::Address: {
+            byte address[20];
+            to_fixed_bytes(value, type, address);
+            return store.make<AddressValue>(address);
+        }
+        case plan::Op::FixedBytes: {
+            bytes32_t bytes;
+            to_fixed_bytes(value, type, bytes);
+            return store.make<FixedBytesValue>(bytes, bytes + type.size);
+        }
+        case plan::Op::Bytes:
+            return store.make<BytesArrayValue>(to_bytes(store, value));
+        case plan::Op::String:
+            return build_string(store, value);
+        case plan::Op::InlineTuple:
+            return build_static(store, p, type, value);
+        case plan::Op::RefTuple:
+            return store.make<RefStructValue>(build_fields(store, p, type, value));
+        case plan::Op::MixedTuple:
+            return store.make<MixedStructValue>(build_fields(store, p, type, value));
+        case plan::Op::FixedUintArray:
+        case plan::Op::DynamicUintArray:
+            return int_builder(type.op, p.node(type.element).size)(store, type, value);
+        case plan::Op::FixedInlineArray:
+            if (is_padded_element(p.node(type.element))) {
+                return build_padded_array(store, p, type, value);
+            }
+            return build_static(store, p, type, value);
+        case plan::Op::FixedRefArray:
+            return store.make<FixedRefArrayValue<DataValue>>(
+                build_elements(store, p, type, value)
+            );
+        case plan::Op::DynamicInlineArray:
+            if (is_padded_element(p.node(type.element))) {
+                return build_padded_array(store, p, type, value);
+            }
+            return build_static_array(store, p, type, value);
+        case plan::Op::DynamicRefArray:
+            return store.make<DynamicRefArrayValue<DataValue>>(
+                build_elements(store, p, type, value)
+            );
+    }
+    throw logic_error("unknown plan op");
+}
+
+// Encodes straight from JS values in one pass, without building a value
+// tree or computing any sizes first. Each list claims its head, writes
+// static elements in place (see `write_static()`), and for each dynamic
+// element patches the element's offset into its head slot and appends its
+// data at the end. Other dynamic values (byte strings and arrays of static
+// elements) are still built by `build_value()`, one at a time into the
+// arena.
+class SinglePassEncoder {
+private:
+    const plan::Plan& _plan;
+    GrowableBuffer& _out;
+    Arena& _arena = Arena::for_this_thread();
+
+    // Dynamic values with elements behind offsets, which get encoded here.
+    static bool has_ref_elements(const plan::Node& type) {
+        switch (type.op) {
+            case plan::Op::RefTuple:
+            case plan::Op::MixedTuple:
+            case plan::Op::FixedRefArray:
+            case plan::Op::DynamicRefArray:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    size_t tuple_head_size(const plan::Node& type) const {
+        size_t size = 0;
+        for (size_t i = 0; i < type.field_count; ++i) {
+            size += _plan.node(_plan.field(type, i).node).head_size;
+        }
+        return size;
+    }
+
+    // Builds a dynamic value and encodes it at the end of the output.
+    void append_built(const plan::Node& type, const Napi::Value& value) {
+        // This encode is on the calling thread, so strings can be read
+        // straight into the output.
+        ValueStore store(_arena, true, true);
+        auto v = build_value(store, _plan, type, value);
+        auto end = _out.append(v->encoded_size());
+        v->encode_to(end);
+    }
+
+    // Encodes a list element whose head slot is at `slot`, in a list whose
+    // head starts at `base`.
+    void encode_slot(
+        const plan::Node& type,
+        const Napi::Value& value,
+        size_t base,
+        size_t slot
+    ) {
+        if (!type.is_dynamic) {
+            return encode_static(type, value, slot);
+        }
+        auto head = _out.at(slot, ETH_WORD_SIZE);
+        write_word(head, _out.size() - base);
+        append_dynamic(type, value);
+    }
+
+    void encode_fields(const plan::Node& type, const Napi::Value& value, size_t base) {
+        bool is_array;
+        auto tuple = to_tuple(value, type, is_array);
+        for (size_t i = 0; i < type.field_count; ++i) {
+            const auto& field = _plan.field(type, i);
+            encode_slot(
+                _plan.node(field.node),
+                get_field(tuple, is_array, field, i),
+                base,
+                base + field.head_offset
+            );
+        }
+    }
+
+    void encode_elements(const plan::Node& type, const Napi::Array& arr, size_t base) {
+        const auto& element = _plan.node(type.element);
+        auto length = arr.Length();
+        for (uint32_t i = 0; i < length; ++i) {
+            encode_slot(element, arr.Get(i), base, base + i * element.head_size);
+        }
+    }
+
+    // Writes a static value into the `type.head_size` bytes at `pos`.
+    void encode_static(const plan::Node& type, const Napi::Value& value, size_t pos) {
+        ValueStore store(_arena, true, true);
+        auto buf = _out.at(pos, type.head_size);
+        write_static(store, _plan, type, value, buf);
+    }
+
+    // Appends a dynamic value at the end of the output.
+    void append_dynamic(const plan::Node& type, const Napi::Value& value) {
+        if (!has_ref_elements(type)) {
+            return append_built(type, value);
+        }
+        if (type.field_count) {
+            auto base = _out.size();
+            _out.append(tuple_head_size(type));
+            return encode_fields(type, value, base);
+        }
+        auto arr = to_array(value, type);
+        size_t length = arr.Length();
+        if (type.op != plan::Op::FixedRefArray) {
+            auto length_word = _out.append(ETH_WORD_SIZE);
+            write_word(length_word, length);
+        }
+        auto base = _out.size();
+        _out.append(plan::checked_size_mul(length, _plan.node(type.element).head_size));
+        encode_elements(type, arr, base);
+    }
+
+public:
+    SinglePassEncoder(const plan::Plan& p, GrowableBuffer& out): _plan(p), _out(out) {}
+
+    // Appends the encoding of the root tuple.
+    void encode(const Napi::Value& values) {
+        const auto& root = _plan.root();
+        auto base = _out.size();
+        _out.append(tuple_head_size(root));
+        encode_fields(root, values, base);
+    }
+};
+
+// compile(typesOrFragment) -> plan
+Napi::Value compile(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    plan::PlanPtr p;
+    try {
+        p = compile_plan(info[0]);
+    } catch (const exception& e) {
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return PlanHandle::New(
+        env,
+        new plan::PlanPtr(p),
+        [](Napi::Env, plan::PlanPtr* p) { delete p; }
+    );
+}
+
+// Reads `{ threads }` from encode options. Large lists are encoded on up to
+// that many threads.
+unsigned to_threads(const Napi::Value& options) {
+    if (!options.IsObject()) {
+        return 1;
+    }
+    auto threads = options.As<Napi::Object>().Get("threads");
+    if (!threads.IsNumber()) {
+        return 1;
+    }
+    auto n = threads.As<Napi::Number>().Int64Value();
+    return unsigned(min(max(n, int64_t(1)), int64_t(256)));
+}
+
+// Reads `{ singlePass }` from encode options.
+bool to_single_pass(const Napi::Value& options) {
+    return options.IsObject()
+        && options.As<Napi::Object>().Get("singlePass").ToBoolean();
+}
+
+// encode() with `{ singlePass: true }`.
+Napi::Value encode_single_pass(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    GrowableBuffer::Lease lease;
+    auto& out = *lease;
+    try {
+        auto p = to_plan(info[0]);
+        if (!info[1].IsArray()) {
+            throw invalid_argument("expected an array of values");
+        }
+        auto prefix = out.append(p->prefix_size());
+        prefix.write(p->selector(), p->selector() + p->prefix_size());
+        SinglePassEncoder(*p, out).encode(info[1]);
+    } catch (const exception& e) {
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    // One copy out of the reused buffer costs less than growing a fresh one.
+    return Napi::Buffer<uint8_t>::Copy(env, (const uint8_t*) out.data(), out.size());
+}
+
+// encode(planOrTypes, values, { threads, singlePass }?) -> Buffer
+//
+// By default values are converted into a value tree, which sizes itself as
+// it is built, and then encoded into an output of exactly that size, on up
+// to `threads` threads. With `singlePass`, values are encoded as they are
+// read into an output that grows as needed, on the calling thread.
+Napi::Value encode(const Napi::CallbackInfo& info) {
+    if (to_single_pass(info[2])) {
+        return encode_single_pass(info);
+    }
+    auto env = info.Env();
+    unsigned threads = to_threads(info[2]);
+    // Values can only read JS during encoding if it stays on this thread.
+    ValueStore store(true, threads == 1);
+    plan::PlanPtr p;
+    DataValue* root;
+    try {
+        p = to_plan(info[0]);
+        if (!info[1].IsArray()) {
+            throw invalid_argument("expected an array of values");
+        }
+        root = build_value(store, *p, p->root(), info[1]);
+    } catch (const exception& e) {
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    // Size the output once and encode straight into it.
+    auto prefix_size = p->prefix_size();
+    auto size = root->encoded_size();
+    auto buf = Napi::Buffer<uint8_t>::New(env, prefix_size + size);
+    auto out = (byte*) buf.Data();
+    copy(p->selector(), p->selector() + prefix_size, out);
+    encode_value(*root, out + prefix_size, size, threads);
+    return buf;
+}
+
+// State shared by the workers of one `encodeBatchAsync()` call.
+struct EncodeBatch {
+    Napi::Promise::Deferred deferred;
+    plan::PlanPtr plan;
+    // Values outlive the call, so they get their own arena.
+    Arena arena;
+    ValueStore store;
+    vector<DataValue*> roots;
+    vector<buf_t> outputs;
+    size_t pending_workers = 0;
+    // Whether a worker failed and rejected the promise.
+    bool failed = false;
+
+    // Workers run after the call returns, so values can't borrow JS memory.
+    EncodeBatch(Napi::Env env)
+        : deferred(Napi::Promise::Deferred::New(env)), store(arena, false) {}
+
+    // Called on the main thread as each worker completes.
+    void worker_done(Napi::Env env) {
+        if (--pending_workers || failed) {
+            return;
+        }
+        auto results = Napi::Array::New(env, outputs.size());
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            if (outputs[i].empty()) {
+                results.Set(uint32_t(i), Napi::Buffer<uint8_t>::New(env, 0));
+                continue;
+            }
+            // Hand the encoded bytes to JS without copying them.
+            auto out = new buf_t(std::move(outputs[i]));
+            results.Set(uint32_t(i), Napi::Buffer<uint8_t>::New(
+                env,
+                (uint8_t*) out->data(),
+                out->size(),
+                [](Napi::Env, uint8_t*, buf_t* out) { delete out; },
+                out
+            ));
+        }
+        deferred.Resolve(results);
+    }
+
+    // Called on the main thread instead when a worker fails. The first
+    // failure rejects the promise; the rest of the batch is dropped.
+    void worker_failed(Napi::Env env, const Napi::Error& error) {
+        if (!failed) {
+            failed = true;
+            deferred.Reject(error.Value());
+        }
+        worker_done(env);
+    }
+};
+
+// Encodes a contiguous range of a batch on the libuv thread pool.
+class EncodeBatchWorker: public Napi::AsyncWorker {
+private:
+    shared_ptr<EncodeBatch> _batch;
+    size_t _begin;
+    size_t _end;
+
+public:
+    EncodeBatchWorker(
+        Napi::Env env,
+        const shared_ptr<EncodeBatch>& batch,
+        size_t begin,
+        size_t end
+    ): Napi::AsyncWorker(env), _batch(batch), _begin(begin), _end(end) {}
+
+    // node-addon-api doesn't catch exceptions thrown here (e.g. `bad_alloc`
+    // on a huge batch) with C++ exceptions disabled, so they are handed to
+    // `OnError()` instead of ending the process.
+    void Execute() override {
+        try {
+            const auto& p = *_batch->plan;
+            auto prefix_size = p.prefix_size();
+            for (size_t i = _begin; i < _end; ++i) {
+                const auto root = _batch->roots[i];
+                auto& out = _batch->outputs[i];
+                out.resize(prefix_size + root->encoded_size());
+                copy(p.selector(), p.selector() + prefix_size, out.data());
+                encode_value(*root, out.data() + prefix_size, out.size() - prefix_size);
+            }
+        } catch (const exception& e) {
+            SetError(e.what());
+        }
+    }
+
+    void OnOK() override {
+        _batch->worker_done(Env());
+    }
+
+    void OnError(const Napi::Error& error) override {
+        _batch->worker_failed(Env(), error);
+    }
+};
+
+// Don't bother splitting a batch into ranges smaller than this.
+static const size_t MIN_WORKER_BATCH_SIZE = 64;
+
+// encodeBatchAsync(planOrTypes, arrayOfValues) -> Promise<Buffer[]>
+Napi::Value encode_batch_async(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    auto batch = make_shared<EncodeBatch>(env);
+    auto promise = batch->deferred.Promise();
+    // Copy all inputs into native values up front so workers never touch JS.
+    try {
+        auto p = batch->plan = to_plan(info[0]);
+        if (!info[1].IsArray()) {
+            throw invalid_argument("expected an array of value arrays");
+        }
+        auto value_sets = info[1].As<Napi::Array>();
+        batch->roots.resize(value_sets.Length());
+        batch->outputs.resize(value_sets.Length());
+        for (uint32_t i = 0; i < value_sets.Length(); ++i) {
+            auto values = value_sets.Get(i);
+            if (!values.IsArray()) {
+                throw invalid_argument("expected an array of values");
+            }
+            batch->roots[i] = build_value(batch->store, *p, p->root(), values);
+        }
+    } catch (const exception& e) {
+        batch->deferred.Reject(Napi::TypeError::New(env, e.what()).Value());
+        return promise;
+    }
+    size_t n = batch->roots.size();
+    size_t max_workers = max(size_t(thread::hardware_concurrency()), size_t(1));
+    size_t num_workers = min(
+        max_workers,
+        max((n + MIN_WORKER_BATCH_SIZE - 1) / MIN_WORKER_BATCH_SIZE, size_t(1))
+    );
+    size_t per_worker = (n + num_workers - 1) / num_workers;
+    batch->pending_workers = num_workers;
+    for (size_t i = 0; i < num_workers; ++i) {
+        auto begin = min(i * per_worker, n);
+        auto end = min(begin + per_worker, n);
+        (new EncodeBatchWorker(env, batch, begin, end))->Queue();
+    }
+    return promise;
+}
+
+// Rejects types `abi.encodePacked` can't encode: tuples, and arrays of
+// anything but static, non-array values.
+void check_packable(const plan::Plan& p, const plan::Node& type, bool in_array) {
+    switch (type.op) {
+        case plan::Op::InlineTuple:
+        case plan::Op::RefTuple:
+        case plan::Op::MixedTuple:
+            throw invalid_argument("tuples can't be packed: " + type.signature);
+        case plan::Op::Bytes:
+        case plan::Op::String:
+            if (in_array) {
+                throw invalid_argument("arrays of dynamic types can't be packed: " + type.signature);
+            }
+            break;
+        case plan::Op::Uint:
+        case plan::Op::Int:
+        case plan::Op::Bool:
+        case plan::Op::Address:
+        case plan::Op::FixedBytes:
+            break;
+        default:
+            if (in_array) {
+                throw invalid_argument("nested arrays can't be packed: " + type.signature);
+            }
+            check_packable(p, p.node(type.element), true);
+    }
+}
+
+// encodePacked(planOrTypes, values) -> Buffer
+Napi::Value encode_packed(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    ValueStore store;
+    array_ref<DataValue* const> values;
+    try {
+        auto p = to_plan(info[0]);
+        const auto& root = p->root();
+        for (size_t i = 0; i < root.field_count; ++i) {
+            check_packable(*p, p->node(p->field(root, i).node), false);
+        }
+        values = build_fields(store, *p, root, info[1]);
+    } catch (const exception& e) {
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    auto size = packed_values_size(values);
+    auto buf = Napi::Buffer<uint8_t>::New(env, size);
+    encode_packed_values(values, (byte*) buf.Data(), size);
+    return buf;
+}
+
+// Builds JS values for `decoder::Decoder`.
+class JsBuilder {
+protected:
+    Napi::Env _env;
+
+public:
+    typedef Napi::Value value_type;
+
+    JsBuilder(Napi::Env env): _env(env) {}
+    Napi::Value uint_value(const byte* word, unsigned) {
+        uint64_t limbs[4];
+        decoder::load_limbs(word, limbs);
+        return Napi::BigInt::New(_env, 0, 4, limbs);
+    }
+    Napi::Value int_value(const byte* word, unsigned) {
+        uint64_t limbs[4];
+        decoder::load_limbs(word, limbs);
+        bool is_negative = unsigned(word[0]) & 0x80;
+        if (is_negative) {
+            // BigInts are sign-magnitude, so negate the two's complement.
+            uint64_t carry = 1;
+            for (size_t i = 0; i < 4; ++i) {
+                limbs[i] = ~limbs[i] + carry;
+                carry = carry && limbs[i] == 0;
+            }
+        }
+        return Napi::BigInt::New(_env, is_negative ? 1 : 0, 4, limbs);
+    }
+    Napi::Value bool_value(bool v) {
+        return Napi::Boolean::New(_env, v);
+    }
+    Napi::Value address_value(const byte* address) {
+        return to_hex_string(_env, address, 20);
+    }
+    Napi::Value bytes_value(const byte* data, size_t size, bool) {
+        return Napi::Buffer<uint8_t>::Copy(_env, (const uint8_t*) data, size);
+    }
+    Napi::Value string_value(const byte* utf8, size_t size) {
+        return Napi::String::New(_env, (const char*) utf8, size);
+    }
+    Napi::Value make_array(size_t length) {
+        return Napi::Array::New(_env, length);
+    }
+    void set_element(Napi::Value& arr, size_t i, Napi::Value v) {
+        arr.As<Napi::Array>().Set(uint32_t(i), v);
+    }
+    // Tuples are arrays with named fields also set as properties.
+    Napi::Value make_tuple(size_t field_count) {
+        return Napi::Array::New(_env, field_count);
+    }
+    Napi::Value make_tuple(const plan::Node& type) {
+        return make_tuple(type.field_count);
+    }
+    void set_field(Napi::Value& t, size_t i, const char* name, Napi::Value v) {
+        auto arr = t.As<Napi::Array>();
+        arr.Set(uint32_t(i), v);
+        if (*name) {
+            arr.Set(name, v);
+        }
+    }
+    void set_field(Napi::Value& t, size_t i, const plan::Field& f, Napi::Value v) {
+        set_field(t, i, f.name.c_str(), v);
+    }
+};
+
+// Builds JS values for lazy views. Byte strings are returned as
+// Uint8Arrays sharing the input's memory instead of copies.
+class ViewBuilder: public JsBuilder {
+private:
+    Napi::Uint8Array _input;
+
+public:
+    ViewBuilder(Napi::Env env, const Napi::Uint8Array& input)
+        : JsBuilder(env), _input(input) {}
+    Napi::Value bytes_value(const byte* data, size_t size, bool) {
+        auto offset = size_t(data - (const byte*) _input.Data());
+        return Napi::Uint8Array::New(
+            _env,
+            size,
+            _input.ArrayBuffer(),
+            _input.ByteOffset() + offset
+        );
+    }
+};
+
+// A tuple or array inside an encoded buffer that decodes fields only when
+// they're accessed. Holds a reference to the buffer instead of copying it.
+class AbiView: public Napi::ObjectWrap<AbiView> {
+private:
+
+    Napi::ObjectReference _input;
+    plan::PlanPtr _plan;
+    const plan::Node* _type = nullptr;
+    size_t _pos = 0;
+
+    decoder::Decoder<ViewBuilder> decoder(ViewBuilder& builder) {
+        auto input = _input.Value().As<Napi::Uint8Array>();
+        auto prefix_size = _plan->prefix_size();
+        return decoder::Decoder<ViewBuilder>(
+            *_plan,
+            builder,
+            (const byte*) input.Data() + prefix_size,
+            input.ByteLength() - prefix_size
+        );
+    }
+
+    bool is_container(const plan::Node& type) const {
+        return type.op >= plan::Op::InlineTuple;
+    }
+
+    // Finds the index of a field by number or name.
+    size_t to_index(const Napi::Value& key, size_t length) {
+        if (key.IsNumber()) {
+            auto i = key.As<Napi::Number>().Int64Value();
+            if (i >= 0 && size_t(i) < length) {
+                return size_t(i);
+            }
+        } else if (key.IsString() && _type->field_count) {
+            auto name = key.As<Napi::String>().Utf8Value();
+            for (size_t i = 0; i < _type->field_count; ++i) {
+                if (_plan->field(*_type, i).name == name) {
+                    return i;
+                }
+            }
+        }
+        throw out_of_range("no such field or element");
+    }
+
+public:
+    static void init(Napi::Env env, Napi::Object exports) {
+        auto ctor = DefineClass(env, "AbiView", {
+            InstanceMethod("get", &AbiView::get),
+            InstanceMethod("decode", &AbiView::decode),
+            InstanceAccessor("length", &AbiView::length, nullptr),
+            InstanceAccessor("type", &AbiView::type, nullptr),
+        });
+        // Per environment, as each worker thread loads its own copy of the
+        // class. Freed with the environment.
+        env.SetInstanceData(new Napi::FunctionReference(Napi::Persistent(ctor)));
+        exports.Set("AbiView", ctor);
+    }
+
+    static Napi::Object create(
+        const Napi::Uint8Array& input,
+        const plan::PlanPtr& p,
+        const plan::Node& type,
+        size_t pos
+    ) {
+        auto obj = input.Env().GetInstanceData<Napi::FunctionReference>()->New({});
+        auto view = Unwrap(obj);
+        view->_input = Napi::Persistent(input.As<Napi::Object>());
+        view->_plan = p;
+        view->_type = &type;
+        view->_pos = pos;
+        return obj;
+    }
+
+    AbiView(const Napi::CallbackInfo& info): Napi::ObjectWrap<AbiView>(info) {}
+
+    // view.get(indexOrName) -> value or nested view
+    Napi::Value get(const Napi::CallbackInfo& info) {
+        auto env = info.Env();
+        if (!_type) {
+            Napi::TypeError::New(env, "AbiView is not bound to a buffer")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        auto input = _input.Value().As<Napi::Uint8Array>();
+        ViewBuilder builder(env, input);
+        auto d = decoder(builder);
+        try {
+            auto i = to_index(info[0], d.length_at(*_type, _pos));
+            const auto& child = d.child_type(*_type, i);
+            auto child_pos = d.child_at(*_type, _pos, i);
+            if (is_container(child)) {
+                return create(input, _plan, child, child_pos);
+            }
+            return d.decode_at(child, child_pos);
+        } catch (const out_of_range& e) {
+            Napi::RangeError::New(env, e.what()).ThrowAsJavaScriptException();
+        } catch (const decoder::decode_error& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        }
+        return env.Undefined();
+    }
+
+    // view.decode() -> fully decoded value
+    Napi::Value decode(const Napi::CallbackInfo& info) {
+        auto env = info.Env();
+        if (!_type) {
+            return env.Undefined();
+        }
+        ViewBuilder builder(env, _input.Value().As<Napi::Uint8Array>());
+        try {
+            return decoder(builder).decode_at(*_type, _pos);
+        } catch (const decoder::decode_error& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+
+    Napi::Value length(const Napi::CallbackInfo& info) {
+        auto env = info.Env();
+        if (!_type) {
+            return env.Undefined();
+        }
+        ViewBuilder builder(env, _input.Value().As<Napi::Uint8Array>());
+        try {
+            return Napi::Number::New(
+                env,
+                double(decoder(builder).length_at(*_type, _pos))
+            );
+        } catch (const decoder::decode_error& e) {
+            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+
+    Napi::Value type(const Napi::CallbackInfo& info) {
+        if (!_type) {
+            return info.Env().Undefined();
+        }
+        return Napi::String::New(info.Env(), _type->signature);
+    }
+};
+
+// Reads the plan and input buffer shared by `decode()` and `decodeView()`.
+// Inputs for plans with a selector must start with it.
+bool to_decode_args(
+    const Napi::CallbackInfo& info,
+    plan::PlanPtr& p,
+    Napi::Uint8Array& input
+) {
+    try {
+        p = to_plan(info[0]);
+        if (!info[1].IsTypedArray()
+                || info[1].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+            throw invalid_argument("expected a Buffer to decode");
+        }
+    } catch (const exception& e) {
+        Napi::TypeError::New(info.Env(), e.what()).ThrowAsJavaScriptException();
+        return false;
+    }
+    input = info[1].As<Napi::Uint8Array>();
+    auto prefix_size = p->prefix_size();
+    if (input.ByteLength() < prefix_size
+            || !equal(p->selector(), p->selector() + prefix_size, (const byte*) input.Data())) {
+        Napi::Error::New(info.Env(), "selector mismatch").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// decodeView(planOrTypes, buffer) -> AbiView
+Napi::Value decode_view(const Napi::CallbackInfo& info) {
+    plan::PlanPtr p;
+    Napi::Uint8Array input;
+    if (!to_decode_args(info, p, input)) {
+        return info.Env().Undefined();
+    }
+    return AbiView::create(input, p, p->root(), 0);
+}
+
+// decode(planOrTypes, buffer) -> Array
+Napi::Value decode(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    plan::PlanPtr p;
+    Napi::Uint8Array data;
+    if (!to_decode_args(info, p, data)) {
+        return env.Undefined();
+    }
+    JsBuilder builder(env);
+    try {
+        auto prefix_size = p->prefix_size();
+        return decoder::Decoder<JsBuilder>(
+            *p,
+            builder,
+            (const byte*) data.Data() + prefix_size,
+            data.ByteLength() - prefix_size
+        ).decode();
+    } catch (const decoder::decode_error& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+}
+
+// keccak256(buffer) -> Buffer
+Napi::Value keccak256(const Napi::CallbackInfo& info) {
+    auto env = info.Env();
+    if (!info[0].IsTypedArray()
+            || info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+        Napi::TypeError::New(env, "expected a Buffer").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    auto data = info[0].As<Napi::Uint8Array>();
+    auto out = Napi::Buffer<uint8_t>::New(env, keccak::KECCAK256_SIZE);
+    keccak::keccak256(
+        (const byte*) data.Data(),
+        data.ByteLength(),
+        (byte*) out.Data()
+    );
+    return out;
+}
+
+// Hashes a signature string or ABI fragment, returning the first `size`
+// bytes as hex.
+Napi::Value hash_signature(const Napi::CallbackInfo& info, size_t size) {
+    auto env = info.Env();
+    string sig;
+    try {
+        sig = to_signature(info[0]);
+    } catch (const exception& e) {
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    byte hash[keccak::KECCAK256_SIZE];
+    keccak::keccak256((const byte*) sig.data(), sig.size(), hash);
+    return to_hex_string(env, hash, size);
+}
+
+// selector(signatureOrFragment) -> '0x...' (4 bytes)
+Napi::Value selector(const Napi::CallbackInfo& info) {
+    return hash_signature(info, 4);
+}
+
+// eventTopic(signatureOrFragment) -> '0x...' (32 bytes)
+Napi::Value event_topic(const Napi::CallbackInfo& info) {
+    return hash_signature(info, keccak::KECCAK256_SIZE);
+}
+
+// JS bindings for the compile-time ABI types of `typed.hpp`, which the code
+// generated from ABI JSON (`src/codegen.js`, included below) instantiates
+// for each function and event. `JsTyped<T>` reads JS values as
+// `build_value()` does, but with every head size and field offset fixed at
+// compile time: static values are written into their words with `write()`,
+// and dynamic ones appended with `append()`, their offsets patched in as
+// `SinglePassEncoder` does. Decoding is `typed.hpp`'s, with a `JsBuilder`.
+template <class T>
+struct JsTyped;
+
+// Appends a value that isn't behind an offset, e.g., call parameters.
+template <class T>
+void append_typed(GrowableBuffer& out, const Napi::Value& value) {
+    if constexpr (T::is_dynamic) {
+        JsTyped<T>::append(out, value);
+    } else {
+        auto buf = out.append(T::head_size);
+        JsTyped<T>::write(buf, value);
+    }
+}
+
+// Encodes a list element whose head slot is at `slot`, in a list whose head
+// starts at `base`.
+template <class T>
+void encode_typed_slot(GrowableBuffer& out, const Napi::Value& value, size_t base, size_t slot) {
+    if constexpr (T::is_dynamic) {
+        auto head = out.at(slot, ETH_WORD_SIZE);
+        write_word(head, out.size() - base);
+        JsTyped<T>::append(out, value);
+    } else {
+        auto buf = out.at(slot, T::head_size);
+        JsTyped<T>::write(buf, value);
+    }
+}
+
+template <unsigned TBits, bool TSigned>
+struct JsTyped<abi::integer<TBits, TSigned>> {
+    static void write(EncodeBuffer& buf, const Napi::Value& value) {
+        write_int<TBits, TSigned>(buf, value);
+    }
+};
+
+template <>
+struct JsTyped<abi::bool_> {
+    static void write(EncodeBuffer& buf, const Napi::Value& value) {
+        write_word(buf, uint8_t(value.ToBoolean() ? 1 : 0));
+    }
+};
+
+template <>
+struct JsTyped<abi::address> {
+    static void write(EncodeBuffer& buf, const Napi::Value& value) {
+        static const string signature = abi::address::signature();
+        auto word = buf.advance(ETH_WORD_SIZE);
+        memset(word, 0, ETH_WORD_SIZE - 20);
+        to_fixed_bytes(value, 20, signature, word + ETH_WORD_SIZE - 20);
+    }
+};
+
+template <size_t TSize>
+struct JsTyped<abi::fixed_bytes<TSize>> {
+    static void write(EncodeBuffer& buf, const Napi::Value& value) {
+        static const string signature = abi::fixed_bytes<TSize>::signature();
+        auto word = buf.advance(ETH_WORD_SIZE);
+        to_fixed_bytes(value, TSize, signature, word);
+        memset(word + TSize, 0, ETH_WORD_SIZE - TSize);
+    }
+};
+
+template <>
+struct JsTyped<abi::bytes> {
+    static void append(GrowableBuffer& out, const Napi::Value& value) {
+        ValueStore store;
+        auto data = to_bytes(store, value);
+        auto buf = out.append(abi::bytes::encoded_size(data));
+        abi::bytes::encode_to(buf, data);
+    }
+};
+
+template <>
+struct JsTyped<abi::string> {
+    static void append(GrowableBuffer& out, const Napi::Value& value) {
+        // Encoded on the calling thread, so the UTF-8 can be read straight
+        // into the output.
+        ValueStore store(true, true);
+        auto s = build_string(store, value);
+        auto buf = out.append(s->encoded_size());
+        s->encode_to(buf);
+    }
+};
+
+template <class T, size_t TLength>
+struct JsTyped<abi::array<T, TLength>> {
+    typedef abi::array<T, TLength> type;
+
+    static Napi::Array elements(const Napi::Value& value) {
+        if (!value.IsArray()) {
+            throw invalid_argument("expected an array for " + type::signature());
+        }
+        auto arr = value.As<Napi::Array>();
+        if (type::is_fixed && arr.Length() != TLength) {
+            throw invalid_argument("wrong array length for " + type::signature());
+        }
+        return arr;
+    }
+
+    static void write(EncodeBuffer& buf, const Napi::Value& value) {
+        auto arr = elements(value);
+        for (uint32_t i = 0; i < TLength; ++i) {
+            JsTyped<T>::write(buf, arr.Get(i));
+        }
+    }
+
+    static void append(GrowableBuffer& out, const Napi::Value& value) {
+        auto arr = elements(value);
+        size_t length = arr.Length();
+        if (!type::is_fixed) {
+            auto length_word = out.append(ETH_WORD_SIZE);
+            write_word(length_word, length);
+        }
+        if constexpr (T::is_dynamic) {
+            auto base = out.size();
+            out.append(length * T::head_size);
+            for (uint32_t i = 0; i < length; ++i) {
+                encode_typed_slot<T>(out, arr.Get(i), base, base + i * T::head_size);
+            }
+        } else {
+            auto buf = out.append(length * T::head_size);
+            for (uint32_t i = 0; i < length; ++i) {
+                JsTyped<T>::write(buf, arr.Get(i));
+            }
+        }
+    }
+};
+
+// Unsigned integer arrays go through `build_uint_array()`, like the generic
+// path, so they take typed arrays too.
+template <unsigned TBits, size_t TLength>
+struct JsTyped<abi::array<abi::uint<TBits>, TLength>> {
+    static const plan::Node& node() {
+        static const plan::Plan p = [] {
+            plan::Plan p;
+            p.set_root(p.add_type(abi::array<abi::uint<TBits>, TLength>::signature()));
+            return p;
+        }();
+        return p.root();
+    }
+
+    static void write(EncodeBuffer& buf, const Napi::Value& value) {
+        ValueStore store;
+        build_uint_array<TBits>(store, node(), value)->encode_to(buf);
+    }
+
+    static void append(GrowableBuffer& out, const Napi::Value& value) {
+        ValueStore store;
+        auto v = build_uint_array<TBits>(store, node(), value);
+        auto buf = out.append(v->encoded_size());
+        v->encode_to(buf);
+    }
+};
+
+// Tuples can be given by position (an array) or by field name (an object).
+template <class TNames, class... Ts>
+struct JsTyped<abi::named_tuple<TNames, Ts...>> {
+    typedef abi::named_tuple<TNames, Ts...> type;
+
+    static Napi::Object fields(const Napi::Value& value, bool& is_array) {
+        if (!value.IsObject()) {
+            throw invalid_argument("expected an array or object for " + type::signature());
+        }
+        is_array = value.IsArray();
+        if (is_array && value.As<Napi::Array>().Length() != sizeof...(Ts)) {
+            throw invalid_argument("wrong number of values for " + type::signature());
+        }
+        return value.As<Napi::Object>();
+    }
+
+    static Napi::Value field(const Napi::Object& tuple, bool is_array, size_t i) {
+        return is_array ? tuple.Get(uint32_t(i)) : tuple.Get(type::name(i));
+    }
+
+    static void write(EncodeBuffer& buf, const Napi::Value& value) {
+        write(buf, value, index_sequence_for<Ts...>());
+    }
+
+    static void append(GrowableBuffer& out, const Napi::Value& value) {
+        append(out, value, index_sequence_for<Ts...>());
+    }
+
+private:
+    template <size_t... I>
+    static void write(EncodeBuffer& buf, const Napi::Value& value, index_sequence<I...>) {
+        bool is_array;
+        // Unused by `()`, which is still checked.
+        [[maybe_unused]] auto tuple = fields(value, is_array);
+        (JsTyped<Ts>::write(buf, field(tuple, is_array, I)), ...);
+    }
+
+    template <size_t... I>
+    static void append(GrowableBuffer& out, const Napi::Value& value, index_sequence<I...>) {
+        bool is_array;
+        auto tuple = fields(value, is_array);
+        auto base = out.size();
+        out.append(type::fields_head_size);
+        (encode_typed_slot<Ts>(
+            out,
+            field(tuple, is_array, I),
+            base,
+            base + type::head_offset(I)
+        ), ...);
+    }
+};
+
+template <class... Ts>
+struct JsTyped<abi::tuple<Ts...>>: JsTyped<abi::named_tuple<void, Ts...>> {};
+
+// Runs a generated binding, throwing bad arguments to JS as TypeErrors
+// and bad data as Errors.
+template <class TFn>
+Napi::Value call_typed(Napi::Env env, TFn fn) {
+    try {
+        return fn();
+    } catch (const decoder::decode_error& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    } catch (const exception& e) {
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+// The bytes of a Buffer to decode, after `prefix`, which they must start
+// with.
+array_ref<const byte> to_typed_input(
+    const Napi::Value& input,
+    const byte* prefix,
+    size_t prefix_size
+) {
+    if (!is_uint8_array(input)) {
+        throw invalid_argument("expected a Buffer to decode");
+    }
+    auto data = input.As<Napi::Uint8Array>();
+    auto p = (const byte*) data.Data();
+    if (data.ByteLength() < prefix_size || !equal(prefix, prefix + prefix_size, p)) {
+        throw decoder::decode_error("selector mismatch");
+    }
+    return array_ref<const byte>(p + prefix_size, data.ByteLength() - prefix_size);
+}
+
+template <class T>
+Napi::Value decode_typed(
+    Napi::Env env,
+    const Napi::Value& input,
+    const byte* prefix,
+    size_t prefix_size
+) {
+    auto data = to_typed_input(input, prefix, prefix_size);
+    JsBuilder builder(env);
+    return decode<T>(builder, data.data(), data.size());
+}
+
+// A function generated from ABI JSON:
+//
+//     { signature, selector, encode(values), decode(calldata), decodeResult(data) }
+//
+// `encode()` takes an array of inputs and returns calldata, as `encode()`
+// with `{ singlePass: true }` does for the same fragment, and the decoders
+// return what `decode()` would.
+template <class TInputs, class TOutputs>
+Napi::Object typed_function(Napi::Env env, const string& name) {
+    auto signature = name + TInputs::signature();
+    byte hash[keccak::KECCAK256_SIZE];
+    keccak::keccak256((const byte*) signature.data(), signature.size(), hash);
+    array<byte, 4> selector;
+    copy(hash, hash + selector.size(), selector.begin());
+
+    auto fn = Napi::Object::New(env);
+    fn.Set("signature", signature);
+    fn.Set("selector", to_hex_string(env, selector.data(), selector.size()));
+    fn.Set("encode", Napi::Function::New(env, [selector](const Napi::CallbackInfo& info) {
+        auto env = info.Env();
+        return call_typed(env, [&]() -> Napi::Value {
+            GrowableBuffer::Lease lease;
+            auto& out = *lease;
+            auto prefix = out.append(selector.size());
+            prefix.write(selector.data(), selector.data() + selector.size());
+            append_typed<TInputs>(out, info[0]);
+            return Napi::Buffer<uint8_t>::Copy(env, (const uint8_t*) out.data(), out.size());
+        });
+    }));
+    fn.Set("decode", Napi::Function::New(env, [selector](const Napi::CallbackInfo& info) {
+        auto env = info.Env();
+        return call_typed(env, [&] {
+            return decode_typed<TInputs>(env, info[0], selector.data(), selector.size());
+        });
+    }));
+    fn.Set("decodeResult", Napi::Function::New(env, [](const Napi::CallbackInfo& info) {
+        auto env = info.Env();
+        return call_typed(env, [&] {
+            return decode_typed<TOutputs>(env, info[0], nullptr, 0);
+        });
+    }));
+    return fn;
+}
+
+// Indexed event parameters of value types are topics as they are; others
+// (byte strings, arrays and tuples) are only there as hashes.
+template <class T>
+struct is_hashed_topic: true_type {};
+template <unsigned TBits, bool TSigned>
+struct is_hashed_topic<abi::integer<TBits, TSigned>>: false_type {};
+template <>
+struct is_hashed_topic<abi::bool_>: false_type {};
+template <>
+struct is_hashed_topic<abi::address>: false_type {};
+template <size_t TSize>
+struct is_hashed_topic<abi::fixed_bytes<TSize>>: false_type {};
+
+// Puts together the parameters of an event, `TParams`, from a log: those
+// flagged in `TIndexed` from its topics (hashes as bytes32), and the rest
+// from its already decoded data.
+template <class TParams, bool... TIndexed>
+class TypedLogDecoder {
+private:
+    JsBuilder& _builder;
+    const decoder::DecodeBuffer& _topics;
+    const Napi::Array& _data;
+    size_t _topic = 0;
+    size_t _data_field = 0;
+
+    template <class T, bool TIsIndexed>
+    Napi::Value next() {
+        if constexpr (!TIsIndexed) {
+            return _data.Get(uint32_t(_data_field++));
+        } else if constexpr (is_hashed_topic<T>::value) {
+            auto w = _topics.word(ETH_WORD_SIZE * _topic++);
+            return _builder.bytes_value(w, ETH_WORD_SIZE, true);
+        } else {
+            return T::decode_at(_builder, _topics, ETH_WORD_SIZE * _topic++);
+        }
+    }
+
+    template <size_t... I, class TNames, class... Ts>
+    Napi::Value decode(index_sequence<I...>, const abi::named_tuple<TNames, Ts...>*) {
+        auto t = _builder.make_tuple(sizeof...(Ts));
+        (_builder.set_field(t, I, TParams::name(I), next<Ts, TIndexed>()), ...);
+        return t;
+    }
+
+public:
+    TypedLogDecoder(
+        JsBuilder& builder,
+        const decoder::DecodeBuffer& topics,
+        const Napi::Array& data
+    ): _builder(builder), _topics(topics), _data(data) {}
+
+    Napi::Value decode() {
+        return decode(make_index_sequence<sizeof...(TIndexed)>(), (const TParams*) nullptr);
+    }
+};
+
+// An event generated from ABI JSON:
+//
+//     { signature, topic, decode(topics, data) }
+//
+// `decode()` takes the topics as Buffers or hex strings, starting with
+// `topic` unless the event is anonymous (and has none).
+template <class TParams, class TData, bool... TIndexed>
+Napi::Object typed_event(Napi::Env env, const string& name, bool is_anonymous) {
+    auto signature = name + TParams::signature();
+    array<byte, keccak::KECCAK256_SIZE> topic;
+    keccak::keccak256((const byte*) signature.data(), signature.size(), topic.data());
+
+    auto event = Napi::Object::New(env);
+    event.Set("signature", signature);
+    if (!is_anonymous) {
+        event.Set("topic", to_hex_string(env, topic.data(), topic.size()));
+    }
+    event.Set("decode", Napi::Function::New(env, [topic, is_anonymous](const Napi::CallbackInfo& info) {
+        auto env = info.Env();
+        return call_typed(env, [&] {
+            const size_t num_indexed = (size_t(TIndexed) + ... + 0);
+            size_t first = is_anonymous ? 0 : 1;
+            if (!info[0].IsArray()) {
+                throw invalid_argument("expected an array of topics");
+            }
+            auto topics = info[0].As<Napi::Array>();
+            if (topics.Length() != first + num_indexed) {
+                throw invalid_argument("wrong number of topics for " + TParams::signature());
+            }
+            buf_t words(topics.Length() * ETH_WORD_SIZE);
+            for (uint32_t i = 0; i < topics.Length(); ++i) {
+                to_fixed_bytes(topics.Get(i), ETH_WORD_SIZE, "bytes32", words.data() + i * ETH_WORD_SIZE);
+            }
+            if (!is_anonymous && !equal(topic.begin(), topic.end(), words.begin())) {
+                throw decoder::decode_error("topic mismatch");
+            }
+            auto data = decode_typed<TData>(env, info[1], nullptr, 0).template As<Napi::Array>();
+            JsBuilder builder(env);
+            decoder::DecodeBuffer indexed(
+                words.data() + first * ETH_WORD_SIZE,
+                num_indexed * ETH_WORD_SIZE
+            );
+            return TypedLogDecoder<TParams, TIndexed...>(builder, indexed, data).decode();
+        });
+    }));
+    return event;
+}
+
+// Defines `generated::contracts(env)`.
+#include "abi_generated.hpp"
+
 Napi::Object init_module(Napi::Env env, Napi::Object exports) {
     exports.Set(
-        Napi::String::New(env, "foo"),
-        Napi::Function::New(env, foo)
+        Napi::String::New(env, "encodePacked"),
+        Napi::Function::New(env, encode_packed)
+    );
+    exports.Set(
+        Napi::String::New(env, "keccak256"),
+        Napi::Function::New(env, keccak256)
+    );
+    exports.Set(
+        Napi::String::New(env, "selector"),
+        Napi::Function::New(env, selector)
+    );
+    exports.Set(
+        Napi::String::New(env, "eventTopic"),
+        Napi::Function::New(env, event_topic)
+    );
+    exports.Set(
+        Napi::String::New(env, "encodeBatchAsync"),
+        Napi::Function::New(env, encode_batch_async)
+    );
+    AbiView::init(env, exports);
+    exports.Set(
+        Napi::String::New(env, "decodeView"),
+        Napi::Function::New(env, decode_view)
+    );
+    exports.Set(
+        Napi::String::New(env, "decode"),
+        Napi::Function::New(env, ::decode)
+    );
+    exports.Set(
+        Napi::String::New(env, "compile"),
+        Napi::Function::New(env, compile)
+    );
+    exports.Set(
+        Napi::String::New(env, "encode"),
+        Napi::Function::New(env, ::encode)
+    );
+    exports.Set(
+        Napi::String::New(env, "contracts"),
+        generated::contracts(env)
     );
     return exports;
 }
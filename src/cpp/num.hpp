@@ -1,31 +1,415 @@
-#include <boost/multiprecision/cpp_int.hpp>
-
-template <unsigned TBits>
-using bigint_t = boost::multiprecision::number<
-    boost::multiprecision::cpp_int_backend<
-        TBits,
-        TBits,
-        boost::multiprecision::signed_magnitude,
-        boost::multiprecision::unchecked,
-        void
-    >
->;
-
-template <unsigned TBits>
-using biguint_t = boost::multiprecision::number<
-    boost::multiprecision::cpp_int_backend<
-        TBits,
-        TBits,
-        boost::multiprecision::unsigned_magnitude,
-        boost::multiprecision::unchecked,
-        void
-    >
->;
-
-typedef biguint_t<256> uint256_t;
-typedef biguint_t<128> uint128_t;
-typedef biguint_t<112> uint112_t;
-
-typedef bigint_t<256> int256_t;
-typedef bigint_t<128> int128_t;
-typedef bigint_t<112> int112_t;
+#pragma once
+#include <string>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace num {
+    using namespace std;
+
+    // A 256-bit integer held as four 64-bit limbs, least significant first.
+    // Signed values are two's complement over the same limbs, so both
+    // variants share one layout and serialize to an ABI word as-is. Trivial
+    // and standard-layout: default construction leaves the limbs
+    // uninitialized, value-initialization (`uint256_t()`) zeroes them.
+    template <bool TSigned>
+    struct wide_int {
+        static const size_t NUM_LIMBS = 4;
+        uint64_t limbs[NUM_LIMBS];
+
+        wide_int() = default;
+
+        // Sign-extends signed natives, zero-extends unsigned ones.
+        template <class T, typename enable_if<is_integral<T>::value, int>::type = 0>
+        constexpr wide_int(T n): limbs{
+            uint64_t(n),
+            is_signed<T>::value && n < 0 ? ~uint64_t(0) : 0,
+            is_signed<T>::value && n < 0 ? ~uint64_t(0) : 0,
+            is_signed<T>::value && n < 0 ? ~uint64_t(0) : 0
+        } {}
+
+        // Reinterprets the bits of the other signedness.
+        constexpr explicit wide_int(const wide_int<!TSigned>& o)
+            : limbs{ o.limbs[0], o.limbs[1], o.limbs[2], o.limbs[3] } {}
+
+        // Parses a decimal or `0x`-prefixed hex string.
+        explicit wide_int(const string& s) {
+            *this = parse(s);
+        }
+
+        constexpr bool is_negative() const {
+            return TSigned && (limbs[NUM_LIMBS - 1] >> 63);
+        }
+
+        // Whether the value is representable in a `bits`-wide integer of
+        // the same signedness, i.e., everything above is zero or sign bits.
+        constexpr bool fits_bits(unsigned bits) const {
+            if (!TSigned) {
+                return !(*this >> bits);
+            }
+            auto high = *this >> (bits - 1);
+            return !high || high == wide_int(-1);
+        }
+
+        // The low limb, truncated to `T`.
+        template <class T, typename enable_if<is_integral<T>::value, int>::type = 0>
+        constexpr explicit operator T() const {
+            return T(limbs[0]);
+        }
+
+        constexpr explicit operator bool() const {
+            return (limbs[0] | limbs[1] | limbs[2] | limbs[3]) != 0;
+        }
+
+        // Writes the value as a 32-byte big-endian word.
+        void store_be(byte* out) const {
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                auto n = limbs[NUM_LIMBS - i - 1];
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                n = __builtin_bswap64(n);
+#endif
+                memcpy(out + i * 8, &n, 8);
+            }
+        }
+
+        static wide_int load_be(const byte* in) {
+            wide_int r;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                uint64_t n;
+                memcpy(&n, in + i * 8, 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                n = __builtin_bswap64(n);
+#endif
+                r.limbs[NUM_LIMBS - i - 1] = n;
+            }
+            return r;
+        }
+
+        // this = this * m + a, returning whatever carries out of 256 bits.
+        constexpr uint64_t mul_add_small(uint64_t m, uint64_t a) {
+            unsigned __int128 carry = a;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                carry += (unsigned __int128) limbs[i] * m;
+                limbs[i] = uint64_t(carry);
+                carry >>= 64;
+            }
+            return uint64_t(carry);
+        }
+
+        // Divides the (unsigned) limbs by `d` in place, returning the
+        // remainder.
+        constexpr uint64_t div_small(uint64_t d) {
+            unsigned __int128 rem = 0;
+            for (size_t i = NUM_LIMBS; i-- > 0;) {
+                rem = (rem << 64) | limbs[i];
+                limbs[i] = uint64_t(rem / d);
+                rem %= d;
+            }
+            return uint64_t(rem);
+        }
+
+        static wide_int parse(const string& s) {
+            size_t i = 0;
+            bool negative = false;
+            if (TSigned && i < s.size() && s[i] == '-') {
+                negative = true;
+                ++i;
+            }
+            if (i == s.size()) {
+                throw invalid_argument("empty integer string");
+            }
+            wide_int<false> r = 0;
+            if (s.size() - i > 2 && s[i] == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+                for (i += 2; i < s.size(); ++i) {
+                    auto c = s[i];
+                    uint64_t digit = c >= '0' && c <= '9' ? c - '0'
+                        : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                        : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                        : 16;
+                    if (digit == 16) {
+                        throw invalid_argument("invalid hex digit");
+                    }
+                    if (r.mul_add_small(16, digit)) {
+                        throw invalid_argument("integer out of range");
+                    }
+                }
+            } else {
+                for (; i < s.size(); ++i) {
+                    if (s[i] < '0' || s[i] > '9') {
+                        throw invalid_argument("invalid decimal digit");
+                    }
+                    if (r.mul_add_small(10, uint64_t(s[i] - '0'))) {
+                        throw invalid_argument("integer out of range");
+                    }
+                }
+            }
+            auto v = wide_int(r);
+            if (negative) {
+                v = -v;
+            }
+            // A signed magnitude must fit in 255 bits (256 for the minimum).
+            if (TSigned && r && v.is_negative() != negative) {
+                throw invalid_argument("integer out of range");
+            }
+            return v;
+        }
+
+        string to_string() const {
+            auto magnitude = wide_int<false>(is_negative() ? -*this : *this);
+            // Peel off 19 decimal digits at a time.
+            static const uint64_t CHUNK = 10000000000000000000ULL;
+            string s;
+            do {
+                auto chunk = magnitude.div_small(CHUNK);
+                for (size_t j = 0; j < 19; ++j) {
+                    s.push_back(char('0' + chunk % 10));
+                    chunk /= 10;
+                    if (!magnitude && !chunk) {
+                        break;
+                    }
+                }
+            } while (magnitude);
+            if (is_negative()) {
+                s.push_back('-');
+            }
+            return string(s.rbegin(), s.rend());
+        }
+
+        friend constexpr wide_int operator~(const wide_int& a) {
+            wide_int r = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                r.limbs[i] = ~a.limbs[i];
+            }
+            return r;
+        }
+
+        friend constexpr wide_int operator&(const wide_int& a, const wide_int& b) {
+            wide_int r = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                r.limbs[i] = a.limbs[i] & b.limbs[i];
+            }
+            return r;
+        }
+
+        friend constexpr wide_int operator|(const wide_int& a, const wide_int& b) {
+            wide_int r = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                r.limbs[i] = a.limbs[i] | b.limbs[i];
+            }
+            return r;
+        }
+
+        friend constexpr wide_int operator^(const wide_int& a, const wide_int& b) {
+            wide_int r = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                r.limbs[i] = a.limbs[i] ^ b.limbs[i];
+            }
+            return r;
+        }
+
+        friend constexpr wide_int operator+(const wide_int& a, const wide_int& b) {
+            wide_int r = 0;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                auto s = a.limbs[i] + b.limbs[i];
+                auto c = uint64_t(s < a.limbs[i]);
+                r.limbs[i] = s + carry;
+                carry = c | uint64_t(r.limbs[i] < s);
+            }
+            return r;
+        }
+
+        friend constexpr wide_int operator-(const wide_int& a, const wide_int& b) {
+            wide_int r = 0;
+            uint64_t borrow = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                auto d = a.limbs[i] - b.limbs[i];
+                auto c = uint64_t(a.limbs[i] < b.limbs[i]);
+                r.limbs[i] = d - borrow;
+                borrow = c | uint64_t(d < borrow);
+            }
+            return r;
+        }
+
+        friend constexpr wide_int operator-(const wide_int& a) {
+            return wide_int(0) - a;
+        }
+
+        // Truncated to the low 256 bits, which is the same for both
+        // signednesses in two's complement.
+        friend constexpr wide_int operator*(const wide_int& a, const wide_int& b) {
+            wide_int r = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                unsigned __int128 carry = 0;
+                for (size_t j = 0; i + j < NUM_LIMBS; ++j) {
+                    carry += (unsigned __int128) a.limbs[i] * b.limbs[j] + r.limbs[i + j];
+                    r.limbs[i + j] = uint64_t(carry);
+                    carry >>= 64;
+                }
+            }
+            return r;
+        }
+
+        friend constexpr wide_int operator<<(const wide_int& a, unsigned n) {
+            wide_int r = 0;
+            if (n >= 256) {
+                return r;
+            }
+            auto limb_shift = n / 64, bit_shift = n % 64;
+            for (size_t i = limb_shift; i < NUM_LIMBS; ++i) {
+                r.limbs[i] = a.limbs[i - limb_shift] << bit_shift;
+                if (bit_shift && i > limb_shift) {
+                    r.limbs[i] |= a.limbs[i - limb_shift - 1] >> (64 - bit_shift);
+                }
+            }
+            return r;
+        }
+
+        // Arithmetic for signed values, logical for unsigned.
+        friend constexpr wide_int operator>>(const wide_int& a, unsigned n) {
+            const uint64_t fill = a.is_negative() ? ~uint64_t(0) : 0;
+            wide_int r = 0;
+            for (size_t i = 0; i < NUM_LIMBS; ++i) {
+                r.limbs[i] = fill;
+            }
+            if (n >= 256) {
+                return r;
+            }
+            auto limb_shift = n / 64, bit_shift = n % 64;
+            for (size_t i = 0; i + limb_shift < NUM_LIMBS; ++i) {
+                auto hi = i + limb_shift + 1 < NUM_LIMBS ? a.limbs[i + limb_shift + 1] : fill;
+                r.limbs[i] = a.limbs[i + limb_shift] >> bit_shift;
+                if (bit_shift) {
+                    r.limbs[i] |= hi << (64 - bit_shift);
+                }
+            }
+            return r;
+        }
+
+        friend constexpr bool operator==(const wide_int& a, const wide_int& b) {
+            return a.limbs[0] == b.limbs[0] && a.limbs[1] == b.limbs[1]
+                && a.limbs[2] == b.limbs[2] && a.limbs[3] == b.limbs[3];
+        }
+
+        friend constexpr bool operator!=(const wide_int& a, const wide_int& b) {
+            return !(a == b);
+        }
+
+        friend constexpr bool operator<(const wide_int& a, const wide_int& b) {
+            if (a.is_negative() != b.is_negative()) {
+                return a.is_negative();
+            }
+            for (size_t i = NUM_LIMBS; i-- > 0;) {
+                if (a.limbs[i] != b.limbs[i]) {
+                    return a.limbs[i] < b.limbs[i];
+                }
+            }
+            return false;
+        }
+
+        friend constexpr bool operator>(const wide_int& a, const wide_int& b) { return b < a; }
+        friend constexpr bool operator<=(const wide_int& a, const wide_int& b) { return !(b < a); }
+        friend constexpr bool operator>=(const wide_int& a, const wide_int& b) { return !(a < b); }
+
+        constexpr wide_int& operator&=(const wide_int& o) { return *this = *this & o; }
+        constexpr wide_int& operator|=(const wide_int& o) { return *this = *this | o; }
+        constexpr wide_int& operator^=(const wide_int& o) { return *this = *this ^ o; }
+        constexpr wide_int& operator+=(const wide_int& o) { return *this = *this + o; }
+        constexpr wide_int& operator-=(const wide_int& o) { return *this = *this - o; }
+        constexpr wide_int& operator*=(const wide_int& o) { return *this = *this * o; }
+        constexpr wide_int& operator<<=(unsigned n) { return *this = *this << n; }
+        constexpr wide_int& operator>>=(unsigned n) { return *this = *this >> n; }
+    };
+}
+
+typedef num::wide_int<false> uint256_t;
+typedef num::wide_int<true> int256_t;
+
+namespace std {
+    template <bool TSigned>
+    class numeric_limits<num::wide_int<TSigned>> {
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = TSigned;
+        static constexpr bool is_integer = true;
+        static constexpr bool is_exact = true;
+        static constexpr int digits = TSigned ? 255 : 256;
+        static constexpr num::wide_int<TSigned> min() {
+            return TSigned ? num::wide_int<TSigned>(1) << 255 : num::wide_int<TSigned>(0);
+        }
+        static constexpr num::wide_int<TSigned> max() {
+            return ~min();
+        }
+    };
+}
+
+// Builds a value from up to four 64-bit limbs, least significant first.
+template <class TNum>
+constexpr TNum from_limbs(const uint64_t* limbs, size_t count) {
+    TNum n = 0;
+    for (size_t i = 0; i < count && i < TNum::NUM_LIMBS; ++i) {
+        n.limbs[i] = limbs[i];
+    }
+    return n;
+}
+
+namespace num {
+    // Native storage by size in bytes; 256-bit values fall back to limbs.
+    template <size_t TSize, bool TSigned>
+    struct native_int;
+    template <> struct native_int<1, false> { typedef uint8_t type; };
+    template <> struct native_int<1, true> { typedef int8_t type; };
+    template <> struct native_int<2, false> { typedef uint16_t type; };
+    template <> struct native_int<2, true> { typedef int16_t type; };
+    template <> struct native_int<4, false> { typedef uint32_t type; };
+    template <> struct native_int<4, true> { typedef int32_t type; };
+    template <> struct native_int<8, false> { typedef uint64_t type; };
+    template <> struct native_int<8, true> { typedef int64_t type; };
+    template <> struct native_int<16, false> { __extension__ typedef unsigned __int128 type; };
+    template <> struct native_int<16, true> { __extension__ typedef __int128 type; };
+    template <bool TSigned> struct native_int<32, TSigned> { typedef wide_int<TSigned> type; };
+
+    constexpr size_t storage_size(unsigned bits) {
+        return bits <= 8 ? 1 : bits <= 16 ? 2 : bits <= 32 ? 4
+            : bits <= 64 ? 8 : bits <= 128 ? 16 : 32;
+    }
+
+    // The narrowest type that holds a `uintN`/`intN`, e.g., `uint32_t` for
+    // `uint24`.
+    template <unsigned TBits, bool TSigned>
+    using int_t = typename native_int<storage_size(TBits), TSigned>::type;
+
+    // Whether `v` is representable in `TBits` bits of its signedness.
+    template <unsigned TBits, class T>
+    constexpr bool fits_bits(const T& v) {
+        if constexpr (TBits >= sizeof(T) * 8) {
+            return true;
+        } else if constexpr (T(-1) < T(0)) {
+            auto high = v >> (TBits - 1);
+            return high == 0 || high == T(-1);
+        } else {
+            return (v >> TBits) == 0;
+        }
+    }
+
+    template <unsigned TBits, bool TSigned>
+    constexpr bool fits_bits(const wide_int<TSigned>& v) {
+        return v.fits_bits(TBits);
+    }
+
+    // Truncates to native (or same-width) storage.
+    template <class T, bool TSigned>
+    constexpr T narrow(const wide_int<TSigned>& w) {
+        if constexpr (sizeof(T) == sizeof(w)) {
+            return T(w);
+        } else if constexpr (sizeof(T) > 8) {
+            __extension__ typedef unsigned __int128 uint128_t;
+            return T((uint128_t(w.limbs[1]) << 64) | w.limbs[0]);
+        } else {
+            return T(w.limbs[0]);
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+// Reference boost::multiprecision types, used only to cross-check `num.hpp`
+// in tests. The addon itself doesn't depend on boost.
+#include <boost/multiprecision/cpp_int.hpp>
+
+namespace num_ref {
+    template <unsigned TBits>
+    using bigint_t = boost::multiprecision::number<
+        boost::multiprecision::cpp_int_backend<
+            TBits,
+            TBits,
+            boost::multiprecision::signed_magnitude,
+            boost::multiprecision::unchecked,
+            void
+        >
+    >;
+
+    template <unsigned TBits>
+    using biguint_t = boost::multiprecision::number<
+        boost::multiprecision::cpp_int_backend<
+            TBits,
+            TBits,
+            boost::multiprecision::unsigned_magnitude,
+            boost::multiprecision::unchecked,
+            void
+        >
+    >;
+
+    typedef biguint_t<256> uint256_t;
+    typedef bigint_t<256> int256_t;
+}
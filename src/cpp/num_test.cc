@@ -0,0 +1,154 @@
+// Checks the 256-bit integers in `num.hpp`, cross-checking them against
+// boost::multiprecision when it is available. Build with node-gyp and run
+// `build/Release/num_test`.
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "num.hpp"
+#if __has_include(<boost/multiprecision/cpp_int.hpp>)
+#include "num_ref.hpp"
+#define HAVE_NUM_REF 1
+#endif
+
+using namespace std;
+
+static size_t failures = 0;
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        ++failures;
+        fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+string hex_word(const byte* word) {
+    static const char* digits = "0123456789abcdef";
+    string s;
+    for (size_t i = 0; i < 32; ++i) {
+        s.push_back(digits[unsigned(word[i]) >> 4]);
+        s.push_back(digits[unsigned(word[i]) & 0xF]);
+    }
+    return s;
+}
+
+template <bool TSigned>
+string hex_word(const num::wide_int<TSigned>& n) {
+    byte word[32];
+    n.store_be(word);
+    return hex_word(word);
+}
+
+// Random values with some limbs zeroed or saturated to reach the carry
+// and sign edge cases.
+template <class TInt>
+TInt random_int(mt19937_64& rng) {
+    TInt n = 0;
+    for (size_t i = 0; i < TInt::NUM_LIMBS; ++i) {
+        switch (rng() % 4) {
+            case 0: n.limbs[i] = 0; break;
+            case 1: n.limbs[i] = ~uint64_t(0); break;
+            default: n.limbs[i] = rng(); break;
+        }
+    }
+    return n;
+}
+
+void test_vectors() {
+    static_assert(is_trivial<uint256_t>::value && is_standard_layout<uint256_t>::value);
+    static_assert(sizeof(uint256_t) == 32 && sizeof(int256_t) == 32);
+    static_assert((uint256_t(1) << 255) >> 255 == uint256_t(1));
+    static_assert((int256_t(1) << 255) >> 255 == int256_t(-1));
+    static_assert(uint256_t(0) - uint256_t(1) == numeric_limits<uint256_t>::max());
+    static_assert(-numeric_limits<int256_t>::max() - 1 == numeric_limits<int256_t>::min());
+
+    const string max_uint =
+        "115792089237316195423570985008687907853269984665640564039457584007913129639935";
+    const string min_int =
+        "-57896044618658097711785492504343953926634992332820282019728792003956564819968";
+    check(numeric_limits<uint256_t>::max().to_string() == max_uint, "max uint256");
+    check(numeric_limits<int256_t>::min().to_string() == min_int, "min int256");
+    check(uint256_t(max_uint) == numeric_limits<uint256_t>::max(), "parse max uint256");
+    check(int256_t(min_int) == numeric_limits<int256_t>::min(), "parse min int256");
+    check(uint256_t(string("0xFF")) == uint256_t(255), "parse hex");
+    check(uint256_t(string("0")).to_string() == "0", "zero");
+    check(int256_t(string("-1")) == int256_t(-1), "parse -1");
+    check(hex_word(int256_t(-1)) == string(64, 'f'), "store -1");
+    check(hex_word(uint256_t(0x1234)) == string(60, '0') + "1234", "store 0x1234");
+    byte word[32];
+    auto n = uint256_t(string("0x0123456789abcdef00112233445566778899aabbccddeeff0f1e2d3c4b5a6978"));
+    n.store_be(word);
+    check(hex_word(word) == "0123456789abcdef00112233445566778899aabbccddeeff0f1e2d3c4b5a6978", "store_be");
+    check(uint256_t::load_be(word) == n, "load_be");
+    for (const string& s : vector<string>{ "", "-", "0x", "12a", "-1", "0x" + string(65, 'f'), max_uint + "0" }) {
+        bool threw = false;
+        try {
+            uint256_t{s};
+        } catch (const invalid_argument&) {
+            threw = true;
+        }
+        check(threw, "uint256 rejects '" + s + "'");
+    }
+    for (const string& s : vector<string>{ min_int.substr(1), "-" + max_uint }) {
+        bool threw = false;
+        try {
+            int256_t{s};
+        } catch (const invalid_argument&) {
+            threw = true;
+        }
+        check(threw, "int256 rejects '" + s + "'");
+    }
+}
+
+#ifdef HAVE_NUM_REF
+void test_against_ref() {
+    mt19937_64 rng(0x5eed);
+    for (size_t i = 0; i < 10000; ++i) {
+        auto a = random_int<uint256_t>(rng);
+        auto b = random_int<uint256_t>(rng);
+        auto n = unsigned(rng() % 260);
+        num_ref::uint256_t ra(a.to_string()), rb(b.to_string());
+        auto same = [&](const uint256_t& x, const num_ref::uint256_t& y, const char* op) {
+            check(x.to_string() == y.str(), a.to_string() + " " + op + " " + b.to_string());
+        };
+        same(a, ra, "parse");
+        same(a + b, num_ref::uint256_t(ra + rb), "+");
+        same(a - b, num_ref::uint256_t(ra - rb), "-");
+        same(a * b, num_ref::uint256_t(ra * rb), "*");
+        same(a & b, num_ref::uint256_t(ra & rb), "&");
+        same(a | b, num_ref::uint256_t(ra | rb), "|");
+        same(a ^ b, num_ref::uint256_t(ra ^ rb), "^");
+        same(~a, num_ref::uint256_t(~ra), "~");
+        same(a << n, n < 256 ? num_ref::uint256_t(ra << n) : 0, "<<");
+        same(a >> n, n < 256 ? num_ref::uint256_t(ra >> n) : 0, ">>");
+        check((a < b) == (ra < rb), "<");
+
+        // Signed values agree with boost on their decimal value, ordering
+        // and negation; boost's sign-magnitude arithmetic doesn't wrap like
+        // two's complement, so compare only operations that can't overflow.
+        auto sa = int256_t(a), sb = int256_t(b);
+        num_ref::int256_t rsa(sa.to_string()), rsb(sb.to_string());
+        check(rsa.str() == sa.to_string(), "signed parse " + sa.to_string());
+        check(int256_t(rsa.str()) == sa, "signed round trip " + sa.to_string());
+        check((sa < sb) == (rsa < rsb), "signed <");
+        if (sa != numeric_limits<int256_t>::min()) {
+            check((-sa).to_string() == num_ref::int256_t(-rsa).str(), "signed -");
+        }
+    }
+}
+#endif
+
+int main() {
+    test_vectors();
+#ifdef HAVE_NUM_REF
+    test_against_ref();
+#else
+    printf("boost not found; skipping reference checks\n");
+#endif
+    if (failures) {
+        printf("%zu failures\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,272 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include "encoders.hpp"
+
+namespace encoder {
+    namespace plan {
+        using namespace std;
+
+        // What to build for a value of a given type. Containers already
+        // encode which list template they map to so that encoding never has
+        // to inspect element types.
+        enum class Op : uint8_t {
+            Uint,
+            Int,
+            Bool,
+            Address,
+            FixedBytes,
+            Bytes,
+            String,
+            InlineTuple,
+            RefTuple,
+            MixedTuple,
+            FixedUintArray,
+            DynamicUintArray,
+            FixedInlineArray,
+            FixedRefArray,
+            DynamicInlineArray,
+            DynamicRefArray
+        };
+
+        struct Field {
+            size_t node;
+            // Offset of the field's slot within the tuple head.
+            size_t head_offset;
+            string name;
+        };
+
+        struct Node {
+            Op op;
+            // Bit width of integers, byte width of fixed bytes.
+            unsigned size;
+            bool is_dynamic;
+            // Space taken in a parent's head.
+            size_t head_size;
+            // Fields of tuples, as a range of `Plan::fields()`.
+            size_t first_field;
+            size_t field_count;
+            // Element type and length of arrays.
+            size_t element;
+            size_t length;
+            // Canonical type, e.g., `(uint256,bytes)[]`.
+            string signature;
+        };
+
+        // Head sizes multiply up array lengths, which can be anything, so
+        // types whose heads wouldn't fit in memory are rejected here rather
+        // than wrapping around into buffers too small for them.
+        inline size_t checked_size_mul(size_t a, size_t b) {
+            size_t n;
+            if (__builtin_mul_overflow(a, b, &n)) {
+                throw invalid_argument("ABI type too large");
+            }
+            return n;
+        }
+
+        inline size_t checked_size_add(size_t a, size_t b) {
+            size_t n;
+            if (__builtin_add_overflow(a, b, &n)) {
+                throw invalid_argument("ABI type too large");
+            }
+            return n;
+        }
+
+        // A flattened ABI type, analyzed once and reused for every encode.
+        class Plan {
+        private:
+            vector<Node> _nodes;
+            vector<Field> _fields;
+            size_t _root = 0;
+            // Function selector written before the encoded root, if any.
+            bool _has_selector = false;
+            byte _selector[4];
+
+            static bool parse_array_type(
+                const string& type,
+                string& element_type,
+                size_t& length,
+                bool& is_fixed
+            ) {
+                if (type.empty() || type.back() != ']') {
+                    return false;
+                }
+                auto open = type.rfind('[');
+                if (open == string::npos) {
+                    throw invalid_argument("invalid ABI type: " + type);
+                }
+                element_type = type.substr(0, open);
+                auto len_str = type.substr(open + 1, type.size() - open - 2);
+                is_fixed = !len_str.empty();
+                length = 0;
+                if (is_fixed) {
+                    if (len_str.find_first_not_of("0123456789") != string::npos) {
+                        throw invalid_argument("invalid ABI array length: " + type);
+                    }
+                    length = stoul(len_str);
+                }
+                return true;
+            }
+
+            // Parses the `N` in `uintN`, `intN` and `bytesN`.
+            static unsigned parse_type_size(
+                const string& type,
+                size_t prefix_len,
+                unsigned default_size,
+                unsigned max_size,
+                unsigned step
+            ) {
+                auto s = type.substr(prefix_len);
+                if (s.empty() && default_size) {
+                    return default_size;
+                }
+                // Sizes are at most 3 digits, and written canonically, as
+                // the type becomes part of the signature.
+                if (s.empty() || s.size() > 3 || s[0] == '0'
+                        || s.find_first_not_of("0123456789") != string::npos) {
+                    throw invalid_argument("invalid ABI type: " + type);
+                }
+                auto n = stoul(s);
+                if (n > max_size || n % step) {
+                    throw invalid_argument("invalid ABI type: " + type);
+                }
+                return unsigned(n);
+            }
+
+            size_t add_node(const Node& node) {
+                _nodes.push_back(node);
+                return _nodes.size() - 1;
+            }
+
+            size_t add_leaf(Op op, unsigned size, bool is_dynamic, const string& sig) {
+                return add_node({ op, size, is_dynamic, ETH_WORD_SIZE, 0, 0, 0, 0, sig });
+            }
+
+            size_t add_array(size_t element, size_t length, bool is_fixed) {
+                const auto e = _nodes[element];
+                Op op;
+                if (e.op == Op::Uint) {
+                    op = is_fixed ? Op::FixedUintArray : Op::DynamicUintArray;
+                } else if (is_fixed) {
+                    op = e.is_dynamic ? Op::FixedRefArray : Op::FixedInlineArray;
+                } else {
+                    op = e.is_dynamic ? Op::DynamicRefArray : Op::DynamicInlineArray;
+                }
+                bool is_dynamic = !is_fixed || e.is_dynamic;
+                return add_node({
+                    op,
+                    0,
+                    is_dynamic,
+                    is_dynamic ? ETH_WORD_SIZE : checked_size_mul(e.head_size, length),
+                    0,
+                    0,
+                    element,
+                    length,
+                    e.signature + "[" + (is_fixed ? to_string(length) : "") + "]"
+                });
+            }
+
+            size_t add_base_type(const string& type, const vector<Field>& components) {
+                if (type == "tuple") {
+                    return add_tuple(components);
+                }
+                if (type == "bool") {
+                    return add_leaf(Op::Bool, 1, false, type);
+                }
+                if (type == "address") {
+                    return add_leaf(Op::Address, 20, false, type);
+                }
+                if (type == "bytes") {
+                    return add_leaf(Op::Bytes, 0, true, type);
+                }
+                if (type == "string") {
+                    return add_leaf(Op::String, 0, true, type);
+                }
+                if (type.compare(0, 5, "bytes") == 0) {
+                    auto size = parse_type_size(type, 5, 0, ETH_WORD_SIZE, 1);
+                    return add_leaf(Op::FixedBytes, size, false, type);
+                }
+                if (type.compare(0, 4, "uint") == 0) {
+                    auto bits = parse_type_size(type, 4, 256, 256, 8);
+                    return add_leaf(Op::Uint, bits, false, "uint" + to_string(bits));
+                }
+                if (type.compare(0, 3, "int") == 0) {
+                    auto bits = parse_type_size(type, 3, 256, 256, 8);
+                    return add_leaf(Op::Int, bits, false, "int" + to_string(bits));
+                }
+                throw invalid_argument("unsupported ABI type: " + type);
+            }
+
+        public:
+            // Adds a type like `uint256[2][]`. `components` are the fields
+            // of the (innermost) tuple, if the type is a tuple.
+            size_t add_type(const string& type, const vector<Field>& components = {}) {
+                string element_type;
+                size_t length;
+                bool is_fixed;
+                if (parse_array_type(type, element_type, length, is_fixed)) {
+                    auto element = add_type(element_type, components);
+                    return add_array(element, length, is_fixed);
+                }
+                return add_base_type(type, components);
+            }
+
+            // Adds a tuple. Only `node` and `name` of each field are used.
+            size_t add_tuple(const vector<Field>& components) {
+                size_t num_dynamic = 0;
+                size_t head_size = 0;
+                string sig = "(";
+                auto first_field = _fields.size();
+                for (auto f = components.cbegin(); f != components.cend(); ++f) {
+                    const auto& n = _nodes[f->node];
+                    _fields.push_back({ f->node, head_size, f->name });
+                    head_size = checked_size_add(head_size, n.head_size);
+                    num_dynamic += n.is_dynamic ? 1 : 0;
+                    if (f != components.cbegin()) {
+                        sig += ",";
+                    }
+                    sig += n.signature;
+                }
+                sig += ")";
+                Op op = Op::MixedTuple;
+                if (num_dynamic == 0) {
+                    op = Op::InlineTuple;
+                } else if (num_dynamic == components.size()) {
+                    op = Op::RefTuple;
+                }
+                bool is_dynamic = num_dynamic != 0;
+                return add_node({
+                    op,
+                    0,
+                    is_dynamic,
+                    is_dynamic ? ETH_WORD_SIZE : head_size,
+                    first_field,
+                    components.size(),
+                    0,
+                    0,
+                    sig
+                });
+            }
+
+            void set_root(size_t root) { _root = root; }
+            const Node& root() const { return _nodes[_root]; }
+            const Node& node(size_t i) const { return _nodes[i]; }
+            const Field& field(const Node& tuple, size_t i) const {
+                return _fields[tuple.first_field + i];
+            }
+            const string& signature() const { return root().signature; }
+            void set_selector(const byte* selector) {
+                copy(selector, selector + sizeof(_selector), _selector);
+                _has_selector = true;
+            }
+            bool has_selector() const { return _has_selector; }
+            const byte* selector() const { return _selector; }
+            // Bytes that precede the encoded root.
+            size_t prefix_size() const { return _has_selector ? sizeof(_selector) : 0; }
+        };
+
+        typedef shared_ptr<const Plan> PlanPtr;
+    }
+}
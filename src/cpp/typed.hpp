@@ -0,0 +1,547 @@
+#pragma once
+#include <array>
+#include <iterator>
+#include <tuple>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include "encoders.hpp"
+#include "decoders.hpp"
+#include "utf8.hpp"
+
+// ABI types known at compile time, for C++ callers with a fixed schema:
+//
+//     auto out = encoder::encode<abi::tuple<abi::uint<256>, abi::address, abi::bytes>>(
+//         amount, to, payload
+//     );
+//
+// Which types are dynamic, head sizes and the positions of static fields
+// are all constants, so encoding is straight-line word writes, with no
+// plan, value tree or virtual calls. Only the sizes of dynamic values are
+// computed at run time, in one pass before writing. Decoding likewise reads
+// fields at constant offsets (see `decode()`).
+namespace encoder {
+    namespace abi {
+        using namespace std;
+
+        // Every ABI type provides:
+        //
+        //     static constexpr bool is_dynamic;
+        //     // Space taken in a parent's head.
+        //     static constexpr size_t head_size;
+        //     // The canonical type, e.g., `(uint256,bytes)[]`.
+        //     static std::string signature();
+        //     template <class V> static size_t encoded_size(const V& v);
+        //     // Writes exactly `encoded_size(v)` bytes.
+        //     template <class V> static void encode_to(EncodeBuffer& buf, const V& v);
+        //     // Decodes the value whose encoding starts at `pos`.
+        //     template <class B>
+        //     static typename B::value_type decode_at(
+        //         B& builder, const decoder::DecodeBuffer& buf, size_t pos
+        //     );
+        //
+        // where `V` can be any C++ type that holds a value of the ABI type,
+        // e.g., any integer for `uint<N>` or any contiguous container of
+        // bytes for `bytes`. Builders are as for `decoder::Decoder`, except
+        // that there is no plan, so tuples are made with
+        // `make_tuple(size_t field_count)` and their fields set with
+        // `set_field(t, i, const char* name, v)`.
+
+        // Bytes of a contiguous container or array of 1-byte elements
+        // (`buf_t`, `std::string`, `array_ref<const byte>`, `byte[20]`, ...).
+        template <class V>
+        array_ref<const byte> bytes_of(const V& v) {
+            static_assert(sizeof(*std::data(v)) == 1, "expected a container of bytes");
+            return array_ref<const byte>((const byte*) std::data(v), std::size(v));
+        }
+
+        // Exactly `N` bytes, from a pointer or a container of that size.
+        template <size_t N, class V>
+        const byte* fixed_bytes_of(const V& v) {
+            if constexpr (is_pointer<V>::value) {
+                static_assert(sizeof(*v) == 1, "expected a pointer to bytes");
+                return (const byte*) v;
+            } else {
+                auto b = bytes_of(v);
+                if (b.size() != N) {
+                    throw invalid_argument("expected " + to_string(N) + " bytes");
+                }
+                return b.data();
+            }
+        }
+
+        template <class V>
+        bool is_negative(const V& v) {
+            if constexpr (is_integral<V>::value) {
+                return is_signed<V>::value && v < 0;
+            } else {
+                return v.is_negative();
+            }
+        }
+
+        // Static types take one word or a fixed run of words.
+        template <size_t TSize>
+        struct static_type {
+            static constexpr bool is_dynamic = false;
+            static constexpr size_t head_size = TSize;
+            template <class V>
+            static constexpr size_t encoded_size(const V&) { return TSize; }
+        };
+
+        // `uintN`/`intN` from any native integer or `uint256_t`/`int256_t`,
+        // checked against the N-bit range.
+        template <unsigned TBits, bool TSigned>
+        struct integer: static_type<ETH_WORD_SIZE> {
+            static_assert(TBits % 8 == 0 && TBits >= 8 && TBits <= 256, "invalid integer width");
+
+            template <class V>
+            static void encode_to(EncodeBuffer& buf, const V& v) {
+                auto n = num::wide_int<TSigned>(v);
+                // Reinterpreting a value of the other signedness flips the
+                // sign of large values.
+                if (n.is_negative() != is_negative(v) || !n.fits_bits(TBits)) {
+                    throw invalid_argument(
+                        "value out of range for " + std::string(TSigned ? "int" : "uint")
+                            + to_string(TBits)
+                    );
+                }
+                write_word(buf, n);
+            }
+
+            // `__int128` isn't `is_integral` under strict `-std=c++17`, so
+            // `wide_int` can't take it; widen it from its two halves.
+            static void encode_to(EncodeBuffer& buf, unsigned __int128 v) {
+                encode_to(buf, num::wide_int<false>(uint64_t(v >> 64)) << 64 | num::wide_int<false>(uint64_t(v)));
+            }
+
+            static void encode_to(EncodeBuffer& buf, __int128 v) {
+                encode_to(buf, num::wide_int<true>(int64_t(v >> 64)) << 64 | num::wide_int<true>(uint64_t(v)));
+            }
+
+            static std::string signature() {
+                return (TSigned ? "int" : "uint") + to_string(TBits);
+            }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                auto w = buf.word(pos);
+                decoder::check_static_word(
+                    w,
+                    TSigned ? plan::Op::Int : plan::Op::Uint,
+                    TBits,
+                    &signature
+                );
+                return TSigned ? builder.int_value(w, TBits) : builder.uint_value(w, TBits);
+            }
+        };
+
+        template <unsigned TBits>
+        using uint = integer<TBits, false>;
+        // `int` is taken.
+        template <unsigned TBits>
+        using int_ = integer<TBits, true>;
+
+        struct bool_: static_type<ETH_WORD_SIZE> {
+            static void encode_to(EncodeBuffer& buf, bool v) {
+                write_word(buf, uint8_t(v ? 1 : 0));
+            }
+
+            static std::string signature() { return "bool"; }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                auto w = buf.word(pos);
+                decoder::check_static_word(w, plan::Op::Bool, 8, &signature);
+                return builder.bool_value(w[31] != byte(0));
+            }
+        };
+
+        // 20 bytes, left-padded to a word.
+        struct address: static_type<ETH_WORD_SIZE> {
+            template <class V>
+            static void encode_to(EncodeBuffer& buf, const V& v) {
+                auto p = buf.advance(ETH_WORD_SIZE);
+                memset(p, 0, ETH_WORD_SIZE - 20);
+                memcpy(p + ETH_WORD_SIZE - 20, fixed_bytes_of<20>(v), 20);
+            }
+
+            static std::string signature() { return "address"; }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                auto w = buf.word(pos);
+                decoder::check_static_word(w, plan::Op::Address, 20, &signature);
+                return builder.address_value(w + ETH_WORD_SIZE - 20);
+            }
+        };
+
+        // `bytesN`, right-padded to a word.
+        template <size_t TSize>
+        struct fixed_bytes: static_type<ETH_WORD_SIZE> {
+            static_assert(TSize >= 1 && TSize <= ETH_WORD_SIZE, "invalid bytesN width");
+
+            template <class V>
+            static void encode_to(EncodeBuffer& buf, const V& v) {
+                auto p = fixed_bytes_of<TSize>(v);
+                write_aligned_bytes(buf, p, p + TSize);
+            }
+
+            static std::string signature() { return "bytes" + to_string(TSize); }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                auto w = buf.word(pos);
+                decoder::check_static_word(w, plan::Op::FixedBytes, TSize, &signature);
+                return builder.bytes_value(w, TSize, true);
+            }
+        };
+
+        struct bytes {
+            static constexpr bool is_dynamic = true;
+            static constexpr size_t head_size = ETH_WORD_SIZE;
+            template <class V>
+            static size_t encoded_size(const V& v) {
+                return ETH_WORD_SIZE + align_size(bytes_of(v).size());
+            }
+            template <class V>
+            static void encode_to(EncodeBuffer& buf, const V& v) {
+                auto b = bytes_of(v);
+                write_word(buf, b.size());
+                write_aligned_bytes(buf, b.data(), b.data() + b.size());
+            }
+
+            static std::string signature() { return "bytes"; }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                auto size = buf.read_size(pos);
+                auto data = buf.bytes(pos + ETH_WORD_SIZE, size);
+                buf.charge(size / ETH_WORD_SIZE);
+                return builder.bytes_value(data, size, false);
+            }
+        };
+
+        // Encodes like `bytes`, from anything convertible to a
+        // `string_view`, which must be valid UTF-8.
+        struct string: bytes {
+            template <class V>
+            static size_t encoded_size(const V& v) {
+                return bytes::encoded_size(string_view(v));
+            }
+            template <class V>
+            static void encode_to(EncodeBuffer& buf, const V& v) {
+                string_view s(v);
+                if (!utf8::is_valid((const byte*) s.data(), s.size())) {
+                    throw invalid_argument("invalid UTF-8 in string");
+                }
+                bytes::encode_to(buf, s);
+            }
+
+            static std::string signature() { return "string"; }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                auto size = buf.read_size(pos);
+                auto data = buf.bytes(pos + ETH_WORD_SIZE, size);
+                buf.charge(size / ETH_WORD_SIZE);
+                if (!utf8::is_valid(data, size)) {
+                    throw decoder::decode_error("invalid UTF-8 in string");
+                }
+                return builder.string_value(data, size);
+            }
+        };
+
+        // Writes the elements of a tuple or array: static elements in
+        // place, dynamic ones as offsets from the start of the head to their
+        // data, which follows the head. Offsets come from where the data
+        // ends up, so no element is sized first.
+        class list_writer {
+        private:
+            EncodeBuffer& _head;
+            size_t _head_pos;
+            EncodeBuffer _data;
+
+        public:
+            list_writer(EncodeBuffer& buf, size_t head_size)
+                : _head(buf), _head_pos(buf.pos()), _data(buf.view(buf.pos() + head_size)) {}
+
+            template <class T, class V>
+            void write(const V& v) {
+                if constexpr (T::is_dynamic) {
+                    write_word(_head, _data.pos() - _head_pos);
+                    T::encode_to(_data, v);
+                } else {
+                    T::encode_to(_head, v);
+                }
+            }
+
+            // Leaves the buffer after the data.
+            void finish() {
+                _head.seek(_data.pos());
+            }
+        };
+
+        // Decodes an element of a tuple or array from its head slot at
+        // `slot`, following its offset from the start of the head, `base`,
+        // if it is dynamic.
+        template <class T, class B>
+        typename B::value_type decode_slot(
+            B& builder,
+            const decoder::DecodeBuffer& buf,
+            size_t base,
+            size_t slot
+        ) {
+            if constexpr (T::is_dynamic) {
+                return T::decode_at(builder, buf, base + buf.read_size(slot));
+            } else {
+                return T::decode_at(builder, buf, slot);
+            }
+        }
+
+        // The length of `T[]`.
+        static constexpr size_t dynamic_length = size_t(-1);
+
+        // `T[]`, or `T[N]` when a length is given, from any container with
+        // `size()` and iterators, e.g., a `std::vector`.
+        template <class T, size_t TLength = dynamic_length>
+        struct array {
+            static constexpr bool is_fixed = TLength != dynamic_length;
+            static constexpr bool is_dynamic = !is_fixed || T::is_dynamic;
+            static constexpr size_t head_size = is_dynamic
+                ? ETH_WORD_SIZE
+                : TLength * T::head_size;
+
+            template <class V>
+            static void check_length(const V& v) {
+                if (is_fixed && size_t(v.size()) != TLength) {
+                    throw invalid_argument("expected " + to_string(TLength) + " elements");
+                }
+            }
+
+            template <class V>
+            static size_t encoded_size(const V& v) {
+                check_length(v);
+                size_t size = is_fixed ? 0 : ETH_WORD_SIZE;
+                if constexpr (T::is_dynamic) {
+                    for (const auto& e : v) {
+                        size += ETH_WORD_SIZE + T::encoded_size(e);
+                    }
+                    return size;
+                } else {
+                    return size + size_t(v.size()) * T::head_size;
+                }
+            }
+
+            template <class V>
+            static void encode_to(EncodeBuffer& buf, const V& v) {
+                check_length(v);
+                size_t length = v.size();
+                if (!is_fixed) {
+                    write_word(buf, length);
+                }
+                list_writer w(buf, length * T::head_size);
+                for (const auto& e : v) {
+                    w.write<T>(e);
+                }
+                w.finish();
+            }
+
+            static std::string signature() {
+                return T::signature() + "[" + (is_fixed ? to_string(TLength) : "") + "]";
+            }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                size_t length = TLength;
+                size_t base = pos;
+                if (!is_fixed) {
+                    length = buf.read_size(pos);
+                    base += ETH_WORD_SIZE;
+                }
+                // Reject lengths the data can't possibly hold before
+                // allocating.
+                if (T::head_size && length > buf.size() / T::head_size) {
+                    throw decoder::decode_error("array length out of bounds");
+                }
+                buf.bytes(base, length * T::head_size);
+                buf.charge(length);
+                auto arr = builder.make_array(length);
+                for (size_t i = 0; i < length; ++i) {
+                    builder.set_element(
+                        arr,
+                        i,
+                        decode_slot<T>(builder, buf, base, base + i * T::head_size)
+                    );
+                }
+                return arr;
+            }
+        };
+
+        // A tuple, from a `std::tuple` (or anything `std::get` works on)
+        // of the fields' values. Fields are named by `TNames::names`, an
+        // array of `sizeof...(Ts)` C strings, or unnamed if `TNames` is
+        // `void`; names only show in decoded values.
+        template <class TNames, class... Ts>
+        struct named_tuple {
+            static constexpr bool is_dynamic = (Ts::is_dynamic || ... || false);
+            // The whole head, in which static fields are inlined.
+            static constexpr size_t fields_head_size = (Ts::head_size + ... + 0);
+            static constexpr size_t head_size = is_dynamic ? ETH_WORD_SIZE : fields_head_size;
+
+            template <class V>
+            static size_t encoded_size(const V& v) {
+                return encoded_size(v, index_sequence_for<Ts...>());
+            }
+
+            template <class V>
+            static void encode_to(EncodeBuffer& buf, const V& v) {
+                encode_to(buf, v, index_sequence_for<Ts...>());
+            }
+
+            static std::string signature() {
+                std::string s = "(";
+                ((s += Ts::signature() + ","), ...);
+                if (s.size() > 1) {
+                    s.pop_back();
+                }
+                return s + ")";
+            }
+
+            static constexpr const char* name(size_t i) {
+                if constexpr (is_void<TNames>::value) {
+                    return "";
+                } else {
+                    return TNames::names[i];
+                }
+            }
+
+            // Where field `i` is in the head.
+            static constexpr size_t head_offset(size_t i) {
+                const size_t sizes[] = { Ts::head_size..., 0 };
+                size_t offset = 0;
+                for (size_t j = 0; j < i; ++j) {
+                    offset += sizes[j];
+                }
+                return offset;
+            }
+
+            template <class B>
+            static typename B::value_type decode_at(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos
+            ) {
+                auto t = builder.make_tuple(sizeof...(Ts));
+                decode_fields(builder, buf, pos, t, index_sequence_for<Ts...>());
+                return t;
+            }
+
+        private:
+            template <class V, size_t... I>
+            static size_t encoded_size(const V& v, index_sequence<I...>) {
+                // Static fields are already in the head.
+                return fields_head_size
+                    + ((Ts::is_dynamic ? Ts::encoded_size(get<I>(v)) : 0) + ... + 0);
+            }
+
+            template <class V, size_t... I>
+            static void encode_to(EncodeBuffer& buf, const V& v, index_sequence<I...>) {
+                list_writer w(buf, fields_head_size);
+                (w.write<Ts>(get<I>(v)), ...);
+                w.finish();
+            }
+
+            template <class B, size_t... I>
+            static void decode_fields(
+                B& builder,
+                const decoder::DecodeBuffer& buf,
+                size_t pos,
+                typename B::value_type& t,
+                index_sequence<I...>
+            ) {
+                (builder.set_field(
+                    t,
+                    I,
+                    name(I),
+                    decode_slot<Ts>(builder, buf, pos, pos + head_offset(I))
+                ), ...);
+            }
+        };
+
+        template <class... Ts>
+        struct tuple: named_tuple<void, Ts...> {};
+
+        template <class T>
+        struct is_tuple: false_type {};
+        template <class... Ts>
+        struct is_tuple<tuple<Ts...>>: true_type {};
+        template <class TNames, class... Ts>
+        struct is_tuple<named_tuple<TNames, Ts...>>: true_type {};
+
+        // The parameters of a call: a tuple's fields, or one value of
+        // another type.
+        template <class T>
+        using params_t = typename conditional<is_tuple<T>::value, T, tuple<T>>::type;
+    }
+
+    // Size of `encode<T>(values...)`.
+    template <class T, class... TValues>
+    size_t encoded_size(const TValues&... values) {
+        return abi::params_t<T>::encoded_size(forward_as_tuple(values...));
+    }
+
+    // Writes the encoding of `values` as the fields of `T` (or as one `T`
+    // if it isn't a tuple) into `buf`, which must have `encoded_size<T>()`
+    // bytes left.
+    template <class T, class... TValues>
+    void encode_into(EncodeBuffer& buf, const TValues&... values) {
+        abi::params_t<T>::encode_to(buf, forward_as_tuple(values...));
+    }
+
+    template <class T, class... TValues>
+    buf_t encode(const TValues&... values) {
+        buf_t out(encoded_size<T>(values...));
+        EncodeBuffer buf(out.data(), out.size());
+        encode_into<T>(buf, values...);
+        assert(buf.pos() == out.size());
+        return out;
+    }
+
+    // Decodes `data` as the fields of `T` (or as one `T` if it isn't a
+    // tuple), into a tuple made by `builder`. Throws `decoder::decode_error`
+    // on malformed data, as `decoder::Decoder` does.
+    template <class T, class TBuilder>
+    typename TBuilder::value_type decode(TBuilder& builder, const byte* data, size_t size) {
+        return abi::params_t<T>::decode_at(builder, decoder::DecodeBuffer(data, size), 0);
+    }
+}
@@ -0,0 +1,361 @@
+// Checks the compile-time ABI types in `typed.hpp` against the Solidity ABI
+// spec examples and against value trees of the same values, and that they
+// decode what they encode. Build with node-gyp and run
+// `build/Release/typed_test`.
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "typed.hpp"
+
+using namespace std;
+using namespace encoder;
+
+static size_t failures = 0;
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        ++failures;
+        fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+string hex(const buf_t& b) {
+    static const char* digits = "0123456789abcdef";
+    string s;
+    for (auto c : b) {
+        s.push_back(digits[unsigned(c) >> 4]);
+        s.push_back(digits[unsigned(c) & 0xF]);
+    }
+    return s;
+}
+
+// Hex of words given by their significant digits.
+string words(const vector<string>& ws) {
+    string s;
+    for (const auto& w : ws) {
+        s += string(64 - w.size(), '0') + w;
+    }
+    return s;
+}
+
+template <class TFn>
+bool throws(TFn fn) {
+    try {
+        fn();
+    } catch (const invalid_argument&) {
+        return true;
+    } catch (const decoder::decode_error&) {
+        return true;
+    }
+    return false;
+}
+
+template <class TFn>
+bool overflows(TFn fn) {
+    try {
+        fn();
+    } catch (const out_of_range&) {
+        return true;
+    }
+    return false;
+}
+
+// Decoded values as text, e.g. `(to=0x11..,amount=5)`. Lists are closed
+// when added to their parent, once all their items are in.
+struct Text {
+    string s;
+    const char* close = "";
+    string str() const { return s + close; }
+};
+
+class TextBuilder {
+public:
+    typedef Text value_type;
+
+    Text uint_value(const byte* word, unsigned) {
+        return { num::wide_int<false>::load_be(word).to_string() };
+    }
+    Text int_value(const byte* word, unsigned) {
+        return { num::wide_int<true>::load_be(word).to_string() };
+    }
+    Text bool_value(bool v) { return { v ? "true" : "false" }; }
+    Text address_value(const byte* address) {
+        return { "0x" + hex(buf_t(address, address + 20)) };
+    }
+    Text bytes_value(const byte* data, size_t size, bool) {
+        return { "0x" + hex(buf_t(data, data + size)) };
+    }
+    Text string_value(const byte* utf8, size_t size) {
+        return { "'" + string((const char*) utf8, size) + "'" };
+    }
+    Text make_array(size_t) { return { "[", "]" }; }
+    void set_element(Text& arr, size_t i, Text v) {
+        arr.s += (i ? "," : "") + v.str();
+    }
+    Text make_tuple(size_t) { return { "(", ")" }; }
+    void set_field(Text& t, size_t i, const char* name, Text v) {
+        t.s += (i ? "," : "") + (*name ? string(name) + "=" : "") + v.str();
+    }
+};
+
+template <class T>
+string decode_text(const buf_t& data) {
+    TextBuilder builder;
+    return decode<T>(builder, data.data(), data.size()).str();
+}
+
+void test_spec_examples() {
+    check(hex(encode<abi::tuple<abi::uint<32>, abi::bool_>>(69, true)) == words({ "45", "1" }), "(uint32,bool)");
+    string dave = "dave";
+    vector<int> numbers = { 1, 2, 3 };
+    check(
+        hex(encode<abi::tuple<abi::bytes, abi::bool_, abi::array<abi::uint<256>>>>(dave, true, numbers))
+            == words({ "60", "1", "a0", "4", "6461766500000000000000000000000000000000000000000000000000000000", "3", "1", "2", "3" }),
+        "(bytes,bool,uint256[])"
+    );
+    string hello = "Hello, world!";
+    vector<uint32_t> pair = { 0x456, 0x789 };
+    check(
+        hex(encode<abi::tuple<abi::uint<256>, abi::array<abi::uint<32>>, abi::fixed_bytes<10>, abi::string>>(0x123, pair, string("1234567890"), hello))
+            == words({
+                "123", "80", "3132333435363738393000000000000000000000000000000000000000000000", "e0",
+                "2", "456", "789",
+                "d", "48656c6c6f2c20776f726c642100000000000000000000000000000000000000",
+            }),
+        "(uint256,uint32[],bytes10,string)"
+    );
+    vector<vector<int>> nested = { { 1, 2 }, { 3 } };
+    check(
+        hex(encode<abi::array<abi::array<abi::uint<256>>>>(nested)) == words({ "20", "2", "40", "a0", "2", "1", "2", "1", "3" }),
+        "uint256[][]"
+    );
+}
+
+void test_layout() {
+    static_assert(!abi::tuple<abi::uint<256>, abi::address>::is_dynamic);
+    static_assert(abi::tuple<abi::uint<256>, abi::address>::head_size == 64);
+    static_assert(abi::tuple<abi::uint<8>, abi::bytes>::is_dynamic);
+    static_assert(abi::tuple<abi::uint<8>, abi::bytes>::head_size == 32);
+    static_assert(abi::tuple<abi::uint<8>, abi::bytes>::fields_head_size == 64);
+    static_assert(abi::array<abi::tuple<abi::uint<8>, abi::address>, 3>::head_size == 192);
+    static_assert(abi::array<abi::bytes, 2>::is_dynamic && abi::array<abi::bytes, 0>::is_dynamic);
+    static_assert(abi::array<abi::uint<8>>::is_dynamic);
+    static_assert(abi::tuple<>::head_size == 0);
+}
+
+// Typed encodings match value trees built from the same values.
+void test_against_values() {
+    values::ValueStore store;
+    byte addr[20];
+    for (size_t i = 0; i < sizeof(addr); ++i) {
+        addr[i] = byte(0x11 * (i % 8));
+    }
+    buf_t payload(45, byte(0xab));
+    auto n = (uint256_t(1) << 200) + uint256_t(7);
+
+    typedef abi::tuple<abi::uint<256>, abi::address, abi::bytes> transfer;
+    auto fields = store.make_array<values::DataValue*>(3);
+    fields[0] = store.make<values::Uint256Value>(n);
+    fields[1] = store.make<values::AddressValue>(addr);
+    fields[2] = store.make<values::BytesArrayValue>(array_ref<const byte>(payload.data(), payload.size()));
+    values::MixedStructValue tree(fields);
+    check(encode<transfer>(n, addr, payload) == encode_value(tree), "(uint256,address,bytes)");
+    check(encoded_size<transfer>(n, addr, payload) == tree.encoded_size(), "(uint256,address,bytes) size");
+
+    // Nested dynamic tuples, behind offsets in an array.
+    typedef abi::tuple<abi::int_<16>, abi::tuple<abi::bytes, abi::bool_>> inner;
+    vector<std::tuple<int, std::tuple<buf_t, bool>>> items = {
+        { -5, { payload, true } },
+        { 300, { buf_t(), false } },
+    };
+    auto elements = store.make_array<values::DataValue*>(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto& data = std::get<0>(std::get<1>(items[i]));
+        auto pair = store.make_array<values::DataValue*>(2);
+        pair[0] = store.make<values::BytesArrayValue>(array_ref<const byte>(data.data(), data.size()));
+        pair[1] = store.make<values::IntValue<8, false>>(uint8_t(std::get<1>(std::get<1>(items[i]))));
+        auto item = store.make_array<values::DataValue*>(2);
+        item[0] = store.make<values::IntValue<16, true>>(int16_t(std::get<0>(items[i])));
+        item[1] = store.make<values::MixedStructValue>(pair);
+        elements[i] = store.make<values::MixedStructValue>(item);
+    }
+    // A lone parameter is still a tuple of one.
+    auto params = store.make_array<values::DataValue*>(1);
+    params[0] = store.make<values::DynamicRefArrayValue<values::DataValue>>(elements);
+    values::RefStructValue list(params);
+    check(encode<abi::array<inner>>(items) == encode_value(list), "(int16,(bytes,bool))[]");
+
+    // Zero-length arrays of dynamic types are still dynamic, as in plans.
+    typedef abi::tuple<abi::uint<8>, abi::array<abi::bytes, 0>> empty;
+    plan::Plan p;
+    p.set_root(p.add_tuple({ { p.add_type("uint8"), 0, "" }, { p.add_type("bytes[0]"), 0, "" } }));
+    const auto& empty_node = p.node(p.field(p.root(), 1).node);
+    check(empty_node.is_dynamic && empty_node.head_size == abi::array<abi::bytes, 0>::head_size, "bytes[0] layout");
+    check(p.root().op == plan::Op::MixedTuple && empty::fields_head_size == 64, "(uint8,bytes[0]) layout");
+    auto empty_fields = store.make_array<values::DataValue*>(2);
+    empty_fields[0] = store.make<values::IntValue<8, false>>(uint8_t(5));
+    empty_fields[1] = store.make<values::FixedRefArrayValue<values::DataValue>>(
+        store.make_array<values::DataValue*>(0)
+    );
+    values::MixedStructValue empty_tree(empty_fields);
+    check(encode<empty>(5, vector<buf_t>()) == encode_value(empty_tree), "(uint8,bytes[0])");
+    check(hex(encode<empty>(5, vector<buf_t>())) == words({ "5", "40" }), "(uint8,bytes[0]) words");
+    check(decode_text<empty>(encode_value(empty_tree)) == "(5,[])", "decode (uint8,bytes[0])");
+}
+
+struct transfer_names {
+    static constexpr const char* names[] = { "to", "amount" };
+};
+
+void test_decode() {
+    string hello = "Hello, world!";
+    vector<uint32_t> pair = { 0x456, 0x789 };
+    typedef abi::tuple<abi::uint<256>, abi::array<abi::uint<32>>, abi::fixed_bytes<10>, abi::string> spec;
+    check(
+        decode_text<spec>(encode<spec>(0x123, pair, string("1234567890"), hello))
+            == "(291,[1110,1929],0x31323334353637383930,'Hello, world!')",
+        "decode (uint256,uint32[],bytes10,string)"
+    );
+    vector<vector<int>> nested = { { 1, 2 }, { 3 } };
+    check(
+        decode_text<abi::array<abi::array<abi::uint<256>>>>(encode<abi::array<abi::array<abi::uint<256>>>>(nested))
+            == "([[1,2],[3]])",
+        "decode uint256[][]"
+    );
+
+    typedef abi::named_tuple<transfer_names, abi::address, abi::int_<16>> transfer;
+    byte addr[20] = {};
+    addr[19] = byte(0xab);
+    vector<std::tuple<buf_t, int>> transfers = { { buf_t(addr, addr + 20), -5 } };
+    check(
+        decode_text<abi::tuple<abi::bool_, abi::array<transfer, 1>>>(encode<abi::tuple<abi::bool_, abi::array<transfer, 1>>>(true, transfers))
+            == "(true,[(to=0x" + string(38, '0') + "ab,amount=-5)])",
+        "decode (bool,(address,int16)[1])"
+    );
+    static_assert(transfer::head_offset(1) == 32);
+    check(
+        abi::array<abi::tuple<abi::uint<8>, abi::bytes>, 2>::signature() == "(uint8,bytes)[2]",
+        "signature (uint8,bytes)[2]"
+    );
+    check(abi::params_t<transfer>::signature() == "(address,int16)", "signature (address,int16)");
+}
+
+void test_errors() {
+    check(throws([] { encode<abi::uint<8>>(256); }), "uint8 overflow");
+    check(throws([] { encode<abi::uint<256>>(-1); }), "negative uint256");
+    check(throws([] { encode<abi::int_<8>>(-129); }), "int8 underflow");
+    check(throws([] { encode<abi::int_<256>>(numeric_limits<uint256_t>::max()); }), "int256 from a large uint256");
+    check(!throws([] { encode<abi::int_<8>>(-128); }), "int8 min");
+    check(throws([] { encode<abi::address>(buf_t(19)); }), "short address");
+    check(throws([] { encode<abi::array<abi::uint<8>, 2>>(vector<int>{ 1 }); }), "short uint8[2]");
+    check(throws([] { encode<abi::string>(std::string("\xc3\x28")); }), "invalid UTF-8");
+
+    auto word = encode<abi::uint<16>>(256);
+    check(throws([&] { decode_text<abi::uint<8>>(word); }), "dirty uint8");
+    check(throws([&] { decode_text<abi::int_<8>>(word); }), "dirty int8");
+    check(throws([&] { decode_text<abi::bool_>(encode<abi::uint<8>>(2)); }), "bool of 2");
+    check(throws([&] { decode_text<abi::tuple<abi::uint<8>, abi::uint<8>>>(word); }), "short data");
+    check(throws([&] { decode_text<abi::array<abi::uint<8>>>(encode<abi::uint<256>>(0x20)); }), "missing length");
+    auto invalid_utf8 = encode<abi::bytes>(std::string("\xc3\x28"));
+    check(throws([&] { decode_text<abi::string>(invalid_utf8); }), "decode invalid UTF-8");
+
+    // Every offset of the outer array points at the same inner array.
+    auto aliased = [](size_t n, size_t m) {
+        buf_t data;
+        auto append = [&](size_t w, size_t count) {
+            auto word = encode<abi::uint<256>>(w);
+            for (size_t i = 0; i < count; ++i) {
+                data.insert(data.end(), word.begin(), word.end());
+            }
+        };
+        append(0x20, 1);
+        append(n, 1);
+        append(n * ETH_WORD_SIZE, n);
+        append(m, 1);
+        append(7, m);
+        return data;
+    };
+    typedef abi::array<abi::array<abi::uint<32>>> nested;
+    check(decode_text<nested>(aliased(2, 2)) == "([[7,7],[7,7]])", "aliased offsets");
+    check(throws([&] { decode_text<nested>(aliased(1000, 1000)); }), "aliased offsets blowing up");
+}
+
+// 128-bit natives aren't `is_integral` under strict `-std=c++17`, which this
+// is built with, so they take their own overloads.
+void test_int128() {
+    __extension__ typedef __int128 int128;
+    __extension__ typedef unsigned __int128 uint128;
+    check(hex(encode<abi::uint<128>>(~uint128(0))) == words({ string(32, 'f') }), "uint128 max");
+    check(hex(encode<abi::uint<256>>(uint128(1) << 100)) == words({ "1" + string(25, '0') }), "uint256 from uint128");
+    check(hex(encode<abi::int_<128>>(int128(-1))) == string(64, 'f'), "int128 -1");
+    check(
+        hex(encode<abi::int_<128>>(int128(uint128(1) << 127))) == string(32, 'f') + "8" + string(31, '0'),
+        "int128 min"
+    );
+    check(hex(encode<abi::int_<256>>(int128(5))) == words({ "5" }), "int256 from int128");
+    check(
+        hex(encode<abi::array<abi::uint<128>, 2>>(vector<uint128>{ 1, 2 })) == words({ "1", "2" }),
+        "uint128[2] from uint128s"
+    );
+    check(throws([] { encode<abi::uint<64>>(uint128(1) << 64); }), "uint64 from a large uint128");
+    check(throws([] { encode<abi::int_<64>>(-(int128(1) << 64)); }), "int64 from a small int128");
+    check(throws([] { encode<abi::uint<128>>(int128(-1)); }), "uint128 from a negative int128");
+    check(throws([] { encode<abi::int_<128>>(~uint128(0)); }), "int128 from uint128 max");
+}
+
+// Checked buffers throw rather than write past their end.
+void test_checked_buffer() {
+    byte words[2 * ETH_WORD_SIZE];
+    auto encode_checked = [&](size_t size, auto fn) {
+        return overflows([&] {
+            auto buf = EncodeBuffer::checked(words, size);
+            fn(buf);
+        });
+    };
+    check(!encode_checked(ETH_WORD_SIZE, [](EncodeBuffer& buf) { encode_into<abi::uint<256>>(buf, 1); }), "word into a word");
+    check(encode_checked(ETH_WORD_SIZE - 1, [](EncodeBuffer& buf) { encode_into<abi::uint<256>>(buf, 1); }), "word into a short buffer");
+    check(encode_checked(sizeof(words), [](EncodeBuffer& buf) { encode_into<abi::bytes>(buf, buf_t(33)); }), "bytes into a short buffer");
+    check(encode_checked(sizeof(words), [](EncodeBuffer& buf) {
+        encode_into<abi::tuple<abi::uint<8>, abi::uint<8>, abi::uint<8>>>(buf, 1, 2, 3);
+    }), "tuple into a short buffer");
+    check(encode_checked(ETH_WORD_SIZE, [](EncodeBuffer& buf) { buf.seek(ETH_WORD_SIZE + 1); }), "seek past the end");
+    check(encode_checked(ETH_WORD_SIZE, [](EncodeBuffer& buf) { buf.view(ETH_WORD_SIZE).advance(1); }), "view at the end");
+    check(EncodeBuffer::checked(words, sizeof(words)).view(0).is_checked(), "views stay checked");
+
+    // Lists long enough to encode on several threads throw overruns on the
+    // calling thread, once every thread is done.
+    values::ValueStore store;
+    buf_t payload(40, byte(1));
+    auto elements = store.make_array<values::DataValue*>(4 * values::PARALLEL_MIN_ELEMENTS);
+    for (auto& e : elements) {
+        e = store.make<values::BytesArrayValue>(array_ref<const byte>(payload.data(), payload.size()));
+    }
+    values::RefListValue list(elements);
+    buf_t serial(list.encoded_size());
+    EncodeBuffer serial_buf(serial.data(), serial.size());
+    list.encode_to(serial_buf);
+    buf_t parallel(list.encoded_size());
+    EncodeBuffer parallel_buf(parallel.data(), parallel.size(), 0, 4, true);
+    list.encode_to(parallel_buf);
+    check(parallel == serial && parallel_buf.pos() == parallel.size(), "parallel list");
+    check(overflows([&] {
+        EncodeBuffer buf(parallel.data(), parallel.size() - 1, 0, 4, true);
+        list.encode_to(buf);
+    }), "parallel list into a short buffer");
+}
+
+int main() {
+    test_spec_examples();
+    test_layout();
+    test_against_values();
+    test_decode();
+    test_errors();
+    test_int128();
+    test_checked_buffer();
+    if (failures) {
+        printf("%zu failures\n", failures);
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace utf8 {
+    using namespace std;
+
+    // Length of the sequence at `p` (at most `n` bytes) if it is a valid,
+    // shortest-form encoding of a scalar value (no surrogates, at most
+    // U+10FFFF), else 0.
+    inline size_t sequence_size(const byte* p, size_t n) {
+        auto b0 = unsigned(p[0]);
+        if (b0 < 0x80) {
+            return 1;
+        }
+        // Allowed range of the second byte, which rules out overlong forms,
+        // surrogates and values above U+10FFFF. Later bytes are 80..BF.
+        size_t size;
+        unsigned lo = 0x80, hi = 0xBF;
+        if (b0 >= 0xC2 && b0 <= 0xDF) {
+            size = 2;
+        } else if (b0 >= 0xE0 && b0 <= 0xEF) {
+            size = 3;
+            if (b0 == 0xE0) {
+                lo = 0xA0;
+            } else if (b0 == 0xED) {
+                hi = 0x9F;
+            }
+        } else if (b0 >= 0xF0 && b0 <= 0xF4) {
+            size = 4;
+            if (b0 == 0xF0) {
+                lo = 0x90;
+            } else if (b0 == 0xF4) {
+                hi = 0x8F;
+            }
+        } else {
+            return 0;
+        }
+        if (n < size) {
+            return 0;
+        }
+        auto b1 = unsigned(p[1]);
+        if (b1 < lo || b1 > hi) {
+            return 0;
+        }
+        for (size_t i = 2; i < size; ++i) {
+            if ((unsigned(p[i]) & 0xC0) != 0x80) {
+                return 0;
+            }
+        }
+        return size;
+    }
+
+    // Whether `n` bytes at `p` are valid UTF-8. Runs of ASCII, the common
+    // case for ABI strings, are skipped 16 bytes at a time (one SSE2 load
+    // and movemask of the high bits, or 8 bytes with a mask test without
+    // SSE2); other sequences are checked one at a time.
+    inline bool is_valid(const byte* p, size_t n) {
+        size_t i = 0;
+        while (i < n) {
+#if defined(__SSE2__)
+            while (n - i >= 16) {
+                auto chunk = _mm_loadu_si128((const __m128i*) (p + i));
+                if (_mm_movemask_epi8(chunk)) {
+                    break;
+                }
+                i += 16;
+            }
+#else
+            while (n - i >= 8) {
+                uint64_t chunk;
+                memcpy(&chunk, p + i, sizeof(chunk));
+                if (chunk & 0x8080808080808080ULL) {
+                    break;
+                }
+                i += 8;
+            }
+#endif
+            // Up to the next ASCII run.
+            while (i < n) {
+                auto size = sequence_size(p + i, n - i);
+                if (!size) {
+                    return false;
+                }
+                i += size;
+                if (size == 1 && n - i >= 16) {
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+}
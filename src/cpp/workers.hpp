@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace encoder {
+    using namespace std;
+
+    // Threads kept for the life of the process to run the tasks of parallel
+    // encodes, so large lists don't each start and join threads of their
+    // own. Threads are started as encodes ask for more of them.
+    class WorkerPool {
+    private:
+        // `count` tasks, each claimed by the first thread to take it.
+        struct Job {
+            const function<void(size_t)>& task;
+            size_t count;
+            atomic<size_t> next{0};
+            // Guarded by the pool's mutex.
+            size_t done = 0;
+            exception_ptr error;
+
+            Job(const function<void(size_t)>& task, size_t count): task(task), count(count) {}
+        };
+
+        mutex _mutex;
+        condition_variable _wake;
+        condition_variable _finished;
+        deque<shared_ptr<Job>> _jobs;
+        vector<thread> _threads;
+        bool _stopping = false;
+
+        // Runs tasks of `job` until none are left to claim.
+        void work(Job& job) {
+            for (size_t i; (i = job.next++) < job.count;) {
+                exception_ptr error;
+                try {
+                    job.task(i);
+                } catch (...) {
+                    error = current_exception();
+                }
+                lock_guard<mutex> lock(_mutex);
+                if (error && !job.error) {
+                    job.error = error;
+                }
+                if (++job.done == job.count) {
+                    _finished.notify_all();
+                }
+            }
+        }
+
+        void run_worker() {
+            unique_lock<mutex> lock(_mutex);
+            while (true) {
+                _wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+                if (_stopping) {
+                    return;
+                }
+                auto job = _jobs.front();
+                if (job->next >= job->count) {
+                    _jobs.pop_front();
+                    continue;
+                }
+                lock.unlock();
+                work(*job);
+                lock.lock();
+            }
+        }
+
+        // Starts threads until there are `n`. The caller does any tasks
+        // left over, so failing to start one only costs parallelism.
+        void reserve(size_t n) {
+            while (_threads.size() < n) {
+                try {
+                    _threads.emplace_back(&WorkerPool::run_worker, this);
+                } catch (const system_error&) {
+                    return;
+                }
+            }
+        }
+
+    public:
+        WorkerPool() = default;
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+        ~WorkerPool() {
+            {
+                lock_guard<mutex> lock(_mutex);
+                _stopping = true;
+            }
+            _wake.notify_all();
+            for (auto& t : _threads) {
+                t.join();
+            }
+        }
+
+        static WorkerPool& shared() {
+            static WorkerPool pool;
+            return pool;
+        }
+
+        // Runs `task(0)` to `task(count - 1)` on the calling thread and up
+        // to `count - 1` workers, returning once all are done. Rethrows the
+        // first exception a task threw, after the rest have finished.
+        void run(size_t count, const function<void(size_t)>& task) {
+            if (count == 0) {
+                return;
+            }
+            auto job = make_shared<Job>(task, count);
+            {
+                lock_guard<mutex> lock(_mutex);
+                reserve(count - 1);
+                _jobs.push_back(job);
+            }
+            _wake.notify_all();
+            work(*job);
+            unique_lock<mutex> lock(_mutex);
+            _finished.wait(lock, [&] { return job->done == job->count; });
+            if (job->error) {
+                rethrow_exception(job->error);
+            }
+        }
+    };
+}
@@ -1,3 +1,544 @@
 'use strict'
-const { foo } = require('../build/Release/index');
-console.log(foo({ name: 'hello' }));
+const assert = require('assert');
+const {
+    compile,
+    contracts,
+    decode,
+    decodeView,
+    encode,
+    encodeBatchAsync,
+    encodePacked,
+    eventTopic,
+    keccak256,
+    selector,
+} = require('../build/Release/index');
+
+function words(...ws) {
+    return ws.map(w => w.padStart(64, '0')).join('');
+}
+
+function hex(buf) {
+    return buf.toString('hex');
+}
+
+// Examples from the Solidity ABI spec.
+assert.strictEqual(
+    hex(encode(['uint32', 'bool'], [69, true])),
+    words('45', '1'),
+);
+assert.strictEqual(
+    hex(encode(
+        ['bytes', 'bool', 'uint256[]'],
+        [Buffer.from('dave'), true, [1, 2, 3]],
+    )),
+    words('60', '1', 'a0', '4', '6461766500000000000000000000000000000000000000000000000000000000', '3', '1', '2', '3'),
+);
+assert.strictEqual(
+    hex(encode(
+        ['uint256', 'uint32[]', 'bytes10', 'bytes'],
+        [0x123, [0x456, 0x789], Buffer.from('1234567890'), Buffer.from('Hello, world!')],
+    )),
+    words(
+        '123', '80', '3132333435363738393000000000000000000000000000000000000000000000', 'e0',
+        '2', '456', '789',
+        'd', '48656c6c6f2c20776f726c642100000000000000000000000000000000000000',
+    ),
+);
+assert.strictEqual(
+    hex(encode(['uint256[][]'], [[[1, 2], [3]]])),
+    words('20', '2', '40', 'a0', '2', '1', '2', '1', '3'),
+);
+// Tuples by position and by name.
+const tupleType = {
+    type: 'tuple',
+    components: [{ name: 'a', type: 'address' }, { name: 'b', type: 'bytes' }],
+};
+const address = '0x' + '11'.repeat(20);
+assert.strictEqual(
+    hex(encode([tupleType], [[address, '0xabcd']])),
+    hex(encode([tupleType], [{ a: address, b: '0xabcd' }])),
+);
+assert.strictEqual(
+    hex(encode([tupleType], [{ a: address, b: '0xabcd' }])),
+    words('20', '11'.repeat(20), '40', '2', 'abcd'.padEnd(64, '0')),
+);
+// Compiled plans encode the same as raw types.
+const plan = compile(['uint256', 'uint32[]', 'bytes10', 'bytes']);
+const planValues = [0x123, [0x456, 0x789], Buffer.from('1234567890'), Buffer.from('Hello, world!')];
+assert.strictEqual(
+    hex(encode(plan, planValues)),
+    hex(encode(['uint256', 'uint32[]', 'bytes10', 'bytes'], planValues)),
+);
+assert.strictEqual(hex(encode(plan, planValues)), hex(encode(plan, planValues)));
+assert.throws(() => encode(plan, [1]));
+assert.throws(() => compile(['uint7']));
+// Sizes are parsed whole and must be canonical, as they go into selectors.
+assert.throws(() => compile(['uint4294967552']), TypeError);
+assert.throws(() => compile(['bytes08']), TypeError);
+assert.throws(() => compile(['uint0256']), TypeError);
+// Types whose heads can't fit in memory, rather than wrapping around.
+assert.throws(
+    () => compile([{ type: 'tuple', components: [{ type: 'bool' }, { type: 'bool[4][2147483648][2147483648]' }] }]),
+    /too large/,
+);
+assert.throws(() => compile(['uint256[576460752303423488]']), /too large/);
+assert.throws(() => encode(['uint8[99999999999999999999999]'], [[]]), TypeError);
+assert.throws(() => encode(['uint256'], ['-1']));
+assert.throws(() => encode(['bytes4'], ['0x1234']));
+assert.throws(() => encode(['foo'], [1]));
+// Plans for arrays of type strings are cached, without mixing up arrays.
+assert.strictEqual(hex(encode(['uint8', 'uint8'], [1, 2])), words('1', '2'));
+assert.strictEqual(hex(encode(['uint8', 'uint8'], [3, 4])), words('3', '4'));
+assert.throws(() => encode(['uint8uint8'], [1]));
+assert.throws(() => encode(['5:uint8'], [1]));
+
+// Numbers, BigInts and strings encode the same.
+{
+    const max = 2n ** 256n - 1n;
+    const min = -(2n ** 255n);
+    assert.strictEqual(hex(encode(['uint256'], [max])), 'ff'.repeat(32));
+    assert.strictEqual(hex(encode(['uint256'], [max])), hex(encode(['uint256'], [max.toString()])));
+    assert.strictEqual(hex(encode(['uint256'], [2n ** 64n])), words('10000000000000000'));
+    assert.strictEqual(hex(encode(['int256'], [min])), '80'.padEnd(64, '0'));
+    assert.strictEqual(hex(encode(['int256'], [-1n])), 'ff'.repeat(32));
+    assert.strictEqual(hex(encode(['int256'], [-(2n ** 64n)])), hex(encode(['int256'], [(-(2n ** 64n)).toString()])));
+    assert.strictEqual(hex(encode(['uint256'], [Number.MAX_SAFE_INTEGER])), words('1fffffffffffff'));
+    assert.strictEqual(hex(encode(['int256'], [-Number.MAX_SAFE_INTEGER])), hex(encode(['int256'], [-(2n ** 53n - 1n)])));
+    assert.strictEqual(hex(encode(['uint256'], [-0])), words('0'));
+    assert.throws(() => encode(['uint256'], [2n ** 256n]));
+    assert.throws(() => encode(['uint256'], [-1n]));
+    assert.throws(() => encode(['uint256'], [-1]));
+    assert.throws(() => encode(['uint256'], [2 ** 53]));
+    assert.throws(() => encode(['uint256'], [1.5]));
+    assert.throws(() => encode(['uint256'], [NaN]));
+}
+
+// Every intN width sign-extends to a full word and rejects out of range values.
+for (let bits = 8; bits <= 256; bits += 8) {
+    const type = `int${bits}`;
+    const min = -(2n ** BigInt(bits - 1));
+    const max = 2n ** BigInt(bits - 1) - 1n;
+    const twos = n => (n < 0n ? 2n ** 256n + n : n).toString(16).padStart(64, '0');
+    for (const n of [min, min + 1n, -1n, 0n, 1n, max]) {
+        const encoded = encode([type], [n]);
+        assert.strictEqual(hex(encoded), twos(n), `${type} ${n}`);
+        assert.strictEqual(decode([type], encoded)[0], n);
+        assert.strictEqual(hex(encodePacked([type], [n])), twos(n).slice(64 - bits / 4));
+    }
+    assert.strictEqual(hex(encode([type], [-1])), 'ff'.repeat(32));
+    assert.strictEqual(hex(encode([type], [String(min)])), twos(min));
+    if (bits < 256) {
+        assert.throws(() => encode([type], [min - 1n]));
+        assert.throws(() => encode([type], [max + 1n]));
+    }
+}
+
+// Every uintN width, alone and as array elements.
+for (let bits = 8; bits <= 256; bits += 8) {
+    const type = `uint${bits}`;
+    const max = 2n ** BigInt(bits) - 1n;
+    const values = [0n, 1n, max];
+    assert.strictEqual(hex(encode([type], [max])), words(max.toString(16)));
+    assert.strictEqual(hex(encodePacked([type], [max])), 'ff'.repeat(bits / 8));
+    assert.strictEqual(hex(encode([`${type}[]`], [values])), words('20', '3', '0', '1', max.toString(16)));
+    assert.strictEqual(hex(encode([`${type}[3]`], [values.map(String)])), words('0', '1', max.toString(16)));
+    assert.deepStrictEqual(decode([`${type}[]`], encode([`${type}[]`], [values]))[0], values);
+    assert.throws(() => encode([type], [max + 1n]));
+    assert.throws(() => encode([`${type}[]`], [[0n, max + 1n]]));
+    // Negative values are reported as such whatever their width and form.
+    for (const n of [-1, -1n, -(2n ** 300n), '-1']) {
+        assert.throws(() => encode([type], [n]), /negative value for unsigned type/);
+    }
+}
+assert.throws(() => encode(['uint8'], [256]));
+assert.throws(() => encode(['uint24[]'], [['0x1000000']]));
+
+// Unsigned typed arrays encode like plain arrays of the same numbers.
+{
+    const numbers = [0, 1, 255, 65535, 4294967295];
+    const typed = new Uint32Array(numbers);
+    assert.strictEqual(hex(encode(['uint32[]'], [typed])), hex(encode(['uint32[]'], [numbers])));
+    assert.strictEqual(hex(encode(['uint256[5]'], [typed])), hex(encode(['uint256[5]'], [numbers])));
+    assert.strictEqual(hex(encodePacked(['uint32[]'], [typed])), hex(encodePacked(['uint32[]'], [numbers])));
+    assert.strictEqual(hex(encode(['uint8[]'], [new Uint8Array([1, 2, 255])])), words('20', '3', '1', '2', 'ff'));
+    assert.strictEqual(hex(encode(['uint16[]'], [new Uint16Array([513])])), words('20', '1', '201'));
+    const bigs = [0n, 2n ** 64n - 1n];
+    assert.strictEqual(hex(encode(['uint64[]'], [new BigUint64Array(bigs)])), hex(encode(['uint64[]'], [bigs])));
+    // Views into a larger buffer read from their own offset.
+    assert.strictEqual(hex(encode(['uint32[]'], [typed.subarray(2, 4)])), words('20', '2', 'ff', 'ffff'));
+    assert.strictEqual(hex(encode(['uint8[]'], [Buffer.from([3, 4])])), words('20', '2', '3', '4'));
+    // Elements wider than the ABI type are range checked.
+    assert.strictEqual(hex(encode(['uint8[]'], [new Uint32Array([255])])), words('20', '1', 'ff'));
+    assert.throws(() => encode(['uint8[]'], [new Uint32Array([256])]));
+    assert.throws(() => encode(['uint256[4]'], [typed]));
+    assert.throws(() => encode(['uint32[]'], [new Int32Array([1])]));
+    // Lengths that aren't a multiple of the vector kernels' width, at
+    // every element size.
+    for (const [type, Typed] of [['uint8', Uint8Array], ['uint16', Uint16Array], ['uint32', Uint32Array], ['uint64', BigUint64Array]]) {
+        const bits = BigInt(Typed.BYTES_PER_ELEMENT * 8);
+        const values = Array.from({ length: 11 }, (_, i) => (2n ** bits - 1n) / BigInt(i + 1));
+        const array = new Typed(Typed === BigUint64Array ? values : values.map(Number));
+        assert.strictEqual(
+            hex(encode([`${type}[]`], [array])),
+            words('20', 'b', ...values.map(v => v.toString(16))),
+        );
+    }
+}
+
+// address[] and bytesN[] encode like their elements one by one.
+{
+    const addresses = ['11', '22', 'ab'].map(b => '0x' + b.repeat(20));
+    const elementWords = addresses.map(a => hex(encode(['address'], [a]))).join('');
+    assert.strictEqual(hex(encode(['address[]'], [addresses])), words('20', '3') + elementWords);
+    assert.strictEqual(hex(encode(['address[3]'], [addresses.map(a => Buffer.from(a.slice(2), 'hex'))])), elementWords);
+    assert.strictEqual(hex(encodePacked(['address[]'], [addresses])), elementWords);
+    assert.deepStrictEqual(decode(['address[]'], encode(['address[]'], [addresses]))[0], addresses);
+    for (const size of [1, 4, 20, 31, 32]) {
+        const items = [Buffer.alloc(size, 0xaa), Buffer.alloc(size, 0x5c)];
+        const expected = items.map(b => hex(encode([`bytes${size}`], [b]))).join('');
+        assert.strictEqual(hex(encode([`bytes${size}[]`], [items])), words('20', '2') + expected);
+        assert.strictEqual(hex(encode([`bytes${size}[2]`], [items.map(hex)])), expected);
+    }
+    assert.strictEqual(hex(encode(['bytes32[]'], [[]])), words('20', '0'));
+    assert.throws(() => encode(['address[]'], [[addresses[0], '0x1234']]));
+    assert.throws(() => encode(['bytes4[]'], [['0x12345678', '0x123456']]));
+    assert.throws(() => encode(['address[2]'], [addresses]));
+}
+
+// Strings encode like bytes of their UTF-8.
+{
+    const strings = ['', 'hello', 'h\u00e9llo \u2713 \u{1f600}', 'x'.repeat(31), 'y'.repeat(32), 'z'.repeat(33), '\u00e9'.repeat(16)];
+    for (const s of strings) {
+        const utf8 = Buffer.from(s, 'utf8');
+        assert.strictEqual(hex(encode(['string'], [s])), hex(encode(['bytes'], [utf8])), s);
+        assert.strictEqual(hex(encodePacked(['string'], [s])), hex(utf8));
+        assert.strictEqual(decode(['string'], encode(['string'], [s]))[0], s);
+    }
+    assert.strictEqual(hex(encode(['string'], ['dave'])), words('20', '4') + '64617665'.padEnd(64, '0'));
+    const types = ['string[]', 'uint8', { type: 'tuple', components: [{ name: 's', type: 'string' }] }];
+    const values = [strings, 7, { s: 'named' }];
+    const decoded = decode(types, encode(types, values));
+    assert.deepStrictEqual(decoded[0], strings);
+    assert.strictEqual(decoded[2].s, 'named');
+    assert.strictEqual(decodeView(types, encode(types, values)).get(0).get(2), strings[2]);
+    // Large string arrays encode the same on several threads.
+    const many = Array.from({ length: 3000 }, (_, i) => 's'.repeat(i % 70));
+    assert.strictEqual(hex(encode(['string[]'], [many], { threads: 4 })), hex(encode(['string[]'], [many])));
+    assert.throws(() => encode(['string'], [Buffer.from('abc')]));
+    assert.throws(() => encodePacked(['string[]'], [['a']]));
+    const invalid = Buffer.from(words('20', '2') + 'c328'.padEnd(64, '0'), 'hex');
+    assert.throws(() => decode(['string'], invalid));
+}
+
+// Deeply nested tuples and arrays round-trip.
+{
+    let type = { type: 'tuple', components: [{ type: 'uint8' }, { type: 'bytes' }] };
+    let value = [1n, Buffer.from('leaf')];
+    for (let level = 2; level <= 6; ++level) {
+        type = {
+            type: 'tuple',
+            components: [{ type: 'uint8' }, { type: 'bytes' }, { ...type, type: 'tuple[]' }, { type: 'uint8[2]' }],
+        };
+        value = [BigInt(level), Buffer.alloc(level * 10, level), [value, value], [1n, 2n]];
+    }
+    assert.deepStrictEqual(decode([type], encode([type], [value]))[0], value);
+}
+
+// Static tuples and arrays encode as their elements' words back to back.
+{
+    const element = {
+        type: 'tuple',
+        components: [{ type: 'uint8' }, { type: 'int16' }, { type: 'address' }, { type: 'bytes2' }, { type: 'bool' }, { type: 'uint32[2]' }],
+    };
+    const values = Array.from({ length: 50 }, (_, i) => [i, -i, address, '0xabcd', i % 2 === 0, new Uint32Array([i, 7])]);
+    const elementWords = values.map(v => hex(encode(element.components.map(c => c.type), v))).join('');
+    assert.strictEqual(hex(encode([{ ...element, type: 'tuple[]' }], [values])), words('20', '32') + elementWords);
+    assert.strictEqual(hex(encode([{ ...element, type: 'tuple[50]' }], [values])), elementWords);
+    assert.strictEqual(hex(encode(['int8[2][]'], [[[-1, 1]]])), words('20', '1') + 'ff'.repeat(32) + words('1'));
+    assert.strictEqual(hex(encodePacked(['bool[]'], [[true, false]])), words('1', '0'));
+    assert.throws(() => encode([{ ...element, type: 'tuple[]' }], [[[256, 0, address, '0xabcd', true, [1, 2]]]]));
+    assert.throws(() => encode([{ ...element, type: 'tuple[]' }], [[[1, 0, '0x11', '0xabcd', true, [1, 2]]]]));
+    assert.throws(() => encode(['uint8[2][]'], [[[1]]]));
+}
+
+// Values are built in a reused arena: big encodes, and encodes after a
+// failed one, are unaffected by what came before.
+{
+    const big = Buffer.alloc(1 << 20, 0x5a);
+    const numbers = Array.from({ length: 10000 }, (_, i) => i);
+    const expected = hex(encode(['bytes', 'uint256[]'], [big, numbers]));
+    assert.throws(() => encode(['bytes', 'uint256[]'], [big, [...numbers, -1]]));
+    assert.strictEqual(hex(encode(['bytes', 'uint256[]'], [big, numbers])), expected);
+    assert.strictEqual(hex(encode(['bytes'], ['0x1234'])), words('20', '2') + '1234'.padEnd(64, '0'));
+    // Buffers are read in place, from their own offset.
+    assert.strictEqual(hex(encode(['bytes'], [big.subarray(10, 12)])), words('20', '2') + '5a5a'.padEnd(64, '0'));
+    assert.strictEqual(hex(encode(['bytes'], [new Uint8Array(0)])), words('20', '0'));
+}
+
+// Single pass encoding matches the default.
+{
+    const singlePass = { singlePass: true };
+    const nested = { type: 'tuple', components: [{ type: 'uint8' }, { type: 'string' }, { ...tupleType, type: 'tuple[2]' }] };
+    const cases = [
+        [['uint32', 'bool'], [69, true]],
+        [['bytes', 'bool', 'uint256[]'], [Buffer.from('dave'), true, [1, 2, 3]]],
+        [['uint256[][]', 'string[]'], [[[1, 2], [3], []], ['', 'héllo', 'x'.repeat(33)]]],
+        [['address[]', 'bytes4[2]', 'uint8[3][]'], [[address, address], ['0xdeadbeef', '0x01020304'], [[1, 2, 3], [4, 5, 6]]]],
+        [[nested, { ...nested, type: 'tuple[]' }, tupleType], [
+            [1, 'a', [[address, '0x01'], { a: address, b: '0x' }]],
+            [],
+            { a: address, b: Buffer.alloc(100, 1) },
+        ]],
+        [plan, planValues],
+        [compile({ name: 'transfer', inputs: [{ type: 'address' }, { type: 'uint' }] }), [address, 100]],
+    ];
+    for (const [types, values] of cases) {
+        assert.strictEqual(hex(encode(types, values, singlePass)), hex(encode(types, values)));
+    }
+    // Outputs much bigger than the initial buffer.
+    const items = Array.from({ length: 2000 }, (_, i) => [i, Buffer.alloc(i % 70, i % 256)]);
+    const itemType = { type: 'tuple[]', components: [{ type: 'uint256' }, { type: 'bytes' }] };
+    assert.strictEqual(hex(encode([itemType], [items], singlePass)), hex(encode([itemType], [items])));
+    assert.throws(() => encode(['uint8'], [256], singlePass));
+    assert.throws(() => encode(['uint8[2]'], [[1]], singlePass));
+    assert.throws(() => encode([tupleType], [[address]], singlePass));
+    assert.throws(() => encode(['uint8'], 1, singlePass));
+    // Encodes started by getters in the middle of one don't disturb it.
+    const reentrant = { type: 'tuple', components: [{ name: 'a', type: 'bytes' }, { name: 'b', type: 'uint256' }] };
+    const getter = {
+        a: Buffer.alloc(40, 1),
+        get b() {
+            encode(['bytes'], [Buffer.alloc(5000)], singlePass);
+            return 5;
+        },
+    };
+    assert.strictEqual(hex(encode([reentrant], [getter], singlePass)), hex(encode([reentrant], [{ a: getter.a, b: 5 }])));
+}
+
+// Decoding.
+{
+    const types = ['uint256', 'int8', 'bool', 'address', 'bytes4', 'bytes', 'uint256[][]', tupleType];
+    const values = [
+        123n, -5n, true, address, '0xdeadbeef', '0x0102',
+        [[1n, 2n], [3n]], [address, '0xabcd'],
+    ];
+    const decoded = decode(types, encode(types, values));
+    assert.strictEqual(decoded[0], 123n);
+    assert.strictEqual(decoded[1], -5n);
+    assert.strictEqual(decoded[2], true);
+    assert.strictEqual(decoded[3], address);
+    assert.strictEqual(hex(decoded[4]), 'deadbeef');
+    assert.strictEqual(hex(decoded[5]), '0102');
+    assert.deepStrictEqual(decoded[6], [[1n, 2n], [3n]]);
+    assert.strictEqual(decoded[7].a, address);
+    assert.strictEqual(hex(decoded[7].b), 'abcd');
+    // Out of bounds offsets and truncated data.
+    const buf = encode(['bytes'], ['0x0102']);
+    assert.throws(() => decode(['bytes'], buf.subarray(0, 40)));
+    const badOffset = Buffer.from(buf);
+    badOffset[31] = 0xff;
+    assert.throws(() => decode(['bytes'], badOffset));
+    assert.throws(() => decode(['uint8'], Buffer.from(words('100'), 'hex')));
+    // Offsets may alias, but not to decode far more than the data holds.
+    const aliased = (n, m) => Buffer.from(words(
+        '20', n.toString(16),
+        ...Array(n).fill((32 * n).toString(16)),
+        m.toString(16), ...Array(m).fill('7'),
+    ), 'hex');
+    assert.deepStrictEqual(decode(['uint256[][]'], aliased(2, 2)), [[[7n, 7n], [7n, 7n]]]);
+    assert.throws(() => decode(['uint256[][]'], aliased(1000, 1000)), /aliased/);
+}
+// Lazy views.
+{
+    const types = ['bytes[]', tupleType, 'uint8'];
+    const big = Buffer.alloc(1000, 7);
+    const buf = encode(types, [[big, big, '0x0102'], [address, '0xabcd'], 9]);
+    const view = decodeView(types, buf);
+    assert.strictEqual(view.length, 3);
+    assert.strictEqual(view.get(2), 9n);
+    assert.strictEqual(view.get(1).type, '(address,bytes)');
+    assert.strictEqual(view.get(1).get('a'), address);
+    const items = view.get(0);
+    assert.strictEqual(items.length, 3);
+    const last = items.get(2);
+    assert.strictEqual(hex(Buffer.from(last)), '0102');
+    // Byte strings share the input's memory.
+    assert.strictEqual(last.buffer, buf.buffer);
+    assert.deepStrictEqual(view.get(1).decode()[0], address);
+    assert.throws(() => items.get(3), RangeError);
+}
+// Parallel encoding of large arrays matches serial encoding.
+{
+    const types = ['bytes[]', { type: 'tuple[]', components: [{ type: 'uint256' }, { type: 'address' }] }];
+    const items = [];
+    const tuples = [];
+    for (let i = 0; i < 5000; ++i) {
+        items.push(Buffer.alloc(i % 100, i % 256));
+        tuples.push([i, address]);
+    }
+    assert.strictEqual(
+        hex(encode(types, [items, tuples], { threads: 4 })),
+        hex(encode(types, [items, tuples])),
+    );
+}
+
+// Keccak, selectors and topics.
+{
+    assert.strictEqual(
+        hex(keccak256(Buffer.alloc(0))),
+        'c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470',
+    );
+    assert.strictEqual(selector('transfer(address,uint256)'), '0xa9059cbb');
+    const transfer = { name: 'transfer', inputs: [{ type: 'address' }, { type: 'uint' }] };
+    assert.strictEqual(selector(transfer), '0xa9059cbb');
+    assert.strictEqual(
+        eventTopic('Transfer(address,address,uint256)'),
+        '0xddf252ad1be2c89b69c2b068fc378daa952ba7f163c4a11628f55a4df523b3ef',
+    );
+    // Function plans prepend the selector.
+    const transferPlan = compile(transfer);
+    const calldata = encode(transferPlan, [address, 100]);
+    assert.strictEqual(hex(calldata), 'a9059cbb' + words('11'.repeat(20), '64'));
+    assert.deepStrictEqual(decode(transferPlan, calldata), [address, 100n]);
+    assert.throws(() => decode(transferPlan, calldata.subarray(1)));
+}
+
+// Packed encoding.
+{
+    assert.strictEqual(
+        hex(encodePacked(
+            ['uint112', 'int8', 'bool', 'address', 'bytes', 'uint8[]', 'bytes2'],
+            [0x1234, -1, true, address, '0xabcd', [1, 2], '0xbeef'],
+        )),
+        '0000000000000000000000001234' + 'ff' + '01' + '11'.repeat(20) + 'abcd'
+            + words('1', '2') + 'beef',
+    );
+    assert.throws(() => encodePacked([tupleType], [[address, '0x']]));
+    assert.throws(() => encodePacked(['bytes[]'], [['0x']]));
+    assert.throws(() => encodePacked(['uint8[][]'], [[[1]]]));
+}
+
+// Bindings generated from `abi/` (see `src/codegen.js`) encode and decode
+// as the generic functions do for the same fragments.
+{
+    const erc20 = require('../abi/erc20.json');
+    const multicall3 = require('../abi/multicall3.json');
+    const fragment = (abi, name) => abi.find(f => f.name === name);
+
+    const transfer = contracts.erc20.functions.transfer;
+    assert.strictEqual(transfer.signature, 'transfer(address,uint256)');
+    assert.strictEqual(transfer.selector, '0xa9059cbb');
+    const calldata = transfer.encode([address, 100]);
+    assert.strictEqual(hex(calldata), hex(encode(compile(fragment(erc20, 'transfer')), [address, 100])));
+    assert.deepStrictEqual(transfer.decode(calldata), [address, 100n]);
+    assert.deepStrictEqual(transfer.decodeResult(encode(['bool'], [true])), [true]);
+    assert.deepStrictEqual(
+        contracts.erc20.functions.name.decodeResult(encode(['string'], ['Token'])),
+        ['Token'],
+    );
+    assert.strictEqual(hex(contracts.erc20.functions.totalSupply.encode([])), '18160ddd');
+    assert.throws(() => transfer.encode([address]), TypeError);
+    assert.throws(() => transfer.encode(['0x1234', 1]), TypeError);
+    assert.throws(() => transfer.decode(calldata.subarray(1)), /selector mismatch/);
+
+    // Dynamic tuples, arrays and bytes, with tuples by position or name.
+    const calls = [
+        { target: address, allowFailure: true, callData: calldata },
+        [address, false, '0x'],
+    ];
+    const aggregate3 = contracts.multicall3.functions.aggregate3;
+    const genericCalldata = encode(compile(fragment(multicall3, 'aggregate3')), [calls]);
+    assert.strictEqual(hex(aggregate3.encode([calls])), hex(genericCalldata));
+    // Encodes started by getters in the middle of one don't disturb it.
+    const reentrant = {
+        target: address,
+        get allowFailure() {
+            transfer.encode([address, 100]);
+            return true;
+        },
+        callData: calldata,
+    };
+    assert.strictEqual(hex(aggregate3.encode([[reentrant, calls[1]]])), hex(genericCalldata));
+    assert.deepStrictEqual(
+        aggregate3.decode(genericCalldata),
+        decode(compile(fragment(multicall3, 'aggregate3')), genericCalldata),
+    );
+    const results = [[true, '0x1234'], [false, '0x']];
+    const returnData = encode(fragment(multicall3, 'aggregate3').outputs, [results]);
+    const decoded = aggregate3.decodeResult(returnData);
+    assert.deepStrictEqual(decoded, decode(fragment(multicall3, 'aggregate3').outputs, returnData));
+    assert.strictEqual(decoded[0][0].success, true);
+    assert.strictEqual(hex(decoded[0][0].returnData), '1234');
+    const tryAggregate = contracts.multicall3.functions.tryAggregate;
+    assert.strictEqual(
+        hex(tryAggregate.encode([true, [[address, calldata]]])),
+        hex(encode(compile(fragment(multicall3, 'tryAggregate')), [true, [[address, calldata]]])),
+    );
+
+    // Events decode their topics and data into named parameters.
+    const Transfer = contracts.erc20.events.Transfer;
+    assert.strictEqual(Transfer.topic, eventTopic('Transfer(address,address,uint256)'));
+    const from = '0x' + '22'.repeat(20);
+    const topic = a => '0x' + a.slice(2).padStart(64, '0');
+    const log = Transfer.decode([Transfer.topic, topic(from), topic(address)], encode(['uint256'], [7]));
+    assert.deepStrictEqual([...log], [from, address, 7n]);
+    assert.strictEqual(log.from, from);
+    assert.strictEqual(log.value, 7n);
+    assert.throws(() => Transfer.decode([Transfer.topic], encode(['uint256'], [7])), TypeError);
+    const approvalTopic = contracts.erc20.events.Approval.topic;
+    assert.throws(() => Transfer.decode([approvalTopic, topic(from), topic(address)], encode(['uint256'], [7])), /topic mismatch/);
+    assert.throws(() => Transfer.decode([Transfer.topic, topic(from), '0x' + 'ff'.repeat(32)], encode(['uint256'], [7])), /dirty/);
+}
+
+(async () => {
+    // Async batches encode the same as encode().
+    const valueSets = [];
+    for (let i = 0; i < 1000; ++i) {
+        valueSets.push([i, [i, i + 1], Buffer.from('1234567890'), Buffer.alloc(i % 70, i % 256)]);
+    }
+    const results = await encodeBatchAsync(plan, valueSets);
+    assert.strictEqual(results.length, valueSets.length);
+    for (let i = 0; i < valueSets.length; ++i) {
+        assert.strictEqual(hex(results[i]), hex(encode(plan, valueSets[i])));
+    }
+    assert.deepStrictEqual(await encodeBatchAsync(plan, []), []);
+    // Typed arrays are copied, so changes after the call don't leak in.
+    const typed = new Uint32Array([7, 8]);
+    const pending = encodeBatchAsync(plan, [[1, typed, Buffer.from('1234567890'), Buffer.alloc(0)]]);
+    typed[0] = 9;
+    assert.strictEqual(
+        hex((await pending)[0]),
+        hex(encode(plan, [1, [7, 8], Buffer.from('1234567890'), Buffer.alloc(0)])),
+    );
+    // So are bytes.
+    const payload = Buffer.from('abcd');
+    const pendingBytes = encodeBatchAsync(['bytes'], [[payload]]);
+    payload[0] = 0;
+    assert.strictEqual(hex((await pendingBytes)[0]), hex(encode(['bytes'], ['0x61626364'])));
+    const strings = ['', 'abc', '\u00e9'.repeat(16), 'x'.repeat(40)].map(s => [s]);
+    const stringResults = await encodeBatchAsync(['string'], strings);
+    assert.deepStrictEqual(stringResults.map(hex), strings.map(s => hex(encode(['string'], s))));
+    await assert.rejects(encodeBatchAsync(plan, [[1]]));
+    // Each worker thread has its own AbiView class, and views here keep
+    // working after a worker that loaded the addon exits.
+    const { Worker } = require('worker_threads');
+    const script = `
+        const { parentPort } = require('worker_threads');
+        const { decodeView, encode, AbiView } = require(${JSON.stringify(require.resolve('../build/Release/index'))});
+        const view = decodeView(['uint8[]'], encode(['uint8[]'], [[1, 2]]));
+        parentPort.postMessage(view instanceof AbiView && view.get(0).get(1) === 2n);
+    `;
+    const [workerOk] = await new Promise((resolve, reject) => {
+        const worker = new Worker(script, { eval: true });
+        worker.on('message', ok => resolve([ok]));
+        worker.on('error', reject);
+    });
+    assert.strictEqual(workerOk, true);
+    const mainView = decodeView(['uint8[]'], encode(['uint8[]'], [[3, 4]]));
+    assert.ok(mainView instanceof require('../build/Release/index').AbiView);
+    assert.strictEqual(mainView.get(0).get(1), 4n);
+    console.log('ok');
+})().catch(err => {
+    console.error(err);
+    process.exit(1);
+});